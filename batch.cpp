@@ -0,0 +1,277 @@
+//
+//	batch.cpp
+//
+//	Runs a manifest of independent jobs, each booting its own
+//	machine from a ROM image with a scripted terminal, spread
+//	over a pool of host threads
+//
+//	Each manifest line holds:
+//
+//		<rom file> <input script, or -> <cycle budget>
+//
+//	Blank lines and lines starting with '#' are ignored.
+//
+
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "hd6309.h"
+#include "mc6850.h"
+#include "memory.h"
+#include "script.h"
+
+struct Job {
+	// from the manifest
+	std::string		rom;
+	std::string		input;
+	Cycles			budget;
+
+	// results
+	enum { pending, done, halted, failed } status = pending;
+	std::string		output;
+	Cycles			cycles = 0;
+	uint64_t		instructions = 0;
+};
+
+static const char *status_name[] = { "pending", "done", "halted", "failed" };
+
+// The same machine as main.cpp, less the disk controller, which
+// would have every job sharing the host's disk images
+static void run_job(Job& job)
+{
+	const Word ram_size = 0x8000;
+	const Word rom_base = 0xc000;
+	const Word rom_size = 0x10000 - rom_base;
+
+	hd6309			cpu;
+	Script			script;
+	bool			failed = false;
+
+	if (job.input != "-" && !script.load(job.input.c_str())) {
+		perror(job.input.c_str());
+		job.status = Job::failed;
+		return;
+	}
+
+	auto ram = std::make_shared<RAM>(ram_size);
+	auto rom = std::make_shared<ROM>(rom_size);
+	auto acia = std::make_shared<mc6850>(script);
+
+	// a ROM that can't be loaded fails just this job
+	if (!rom->try_load(job.rom.c_str(), rom_base)) {
+		job.status = Job::failed;
+		return;
+	}
+
+	cpu.attach(ram, 0x0000, ~(ram_size - 1));
+	cpu.attach(rom, rom_base, ~(rom_size - 1));
+	cpu.attach(acia, 0xa000, 0xfffe);
+
+	acia->IRQ_line.connect(cpu.FIRQ_line);
+
+	// an invalid instruction ends just this job
+	cpu.abort = [&]() {
+		failed = true;
+		cpu.halt();
+	};
+
+	cpu.reset();
+	job.cycles = cpu.run_for(job.budget);
+	job.instructions = cpu.instruction_count();
+	job.output = script.get_output();
+
+	if (failed) {
+		job.status = Job::failed;
+	} else if (job.cycles < job.budget) {
+		job.status = Job::halted;
+	} else {
+		job.status = Job::done;
+	}
+}
+
+static bool read_manifest(const char *filename, std::vector<Job>& jobs)
+{
+	std::ifstream in(filename);
+	if (!in) {
+		perror(filename);
+		return false;
+	}
+
+	std::string line;
+	for (int n = 1; std::getline(in, line); ++n) {
+		std::istringstream fields(line);
+		Job job;
+
+		if (!(fields >> job.rom) || job.rom[0] == '#') {
+			continue;
+		}
+		if (!(fields >> job.input >> job.budget)) {
+			fprintf(stderr, "%s:%d: expected <rom> <input> <cycles>\n", filename, n);
+			return false;
+		}
+
+		jobs.push_back(job);
+	}
+
+	return true;
+}
+
+/*
+ * a pool of threads, each with its own queue of job numbers,
+ * which takes work from the back of another thread's queue
+ * whenever its own runs dry
+ */
+class Pool {
+
+protected:
+	struct Queue {
+		std::mutex			lock;
+		std::deque<size_t>	jobs;
+	};
+
+	std::vector<Job>&	jobs;
+	std::vector<Queue>	queues;
+
+	bool				take(size_t worker, size_t& job);
+	void				work(size_t worker);
+
+public:
+	void				run();
+
+public:
+						Pool(std::vector<Job>& jobs, size_t threads);
+};
+
+Pool::Pool(std::vector<Job>& jobs, size_t threads)
+	: jobs(jobs), queues(threads)
+{
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		queues[i % threads].jobs.push_back(i);
+	}
+}
+
+bool Pool::take(size_t worker, size_t& job)
+{
+	// no more jobs are ever queued, so once every queue
+	// has been found empty this worker is finished
+	for (size_t i = 0; i < queues.size(); ++i) {
+		Queue& q = queues[(worker + i) % queues.size()];
+		std::lock_guard<std::mutex> guard(q.lock);
+
+		if (q.jobs.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			job = q.jobs.front();
+			q.jobs.pop_front();
+		} else {
+			job = q.jobs.back();
+			q.jobs.pop_back();
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void Pool::work(size_t worker)
+{
+	size_t job;
+	while (take(worker, job)) {
+		run_job(jobs[job]);
+	}
+}
+
+void Pool::run()
+{
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < queues.size(); ++i) {
+		threads.emplace_back(&Pool::work, this, i);
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+}
+
+static bool write_output(const std::string& dir, size_t n, const Job& job)
+{
+	std::string filename = dir + "/" + std::to_string(n) + ".out";
+	FILE *fp = fopen(filename.c_str(), "w");
+
+	if (!fp) {
+		perror(filename.c_str());
+		return false;
+	}
+	fwrite(job.output.data(), 1, job.output.size(), fp);
+	fclose(fp);
+
+	return true;
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: usim-batch [-j threads] [-o outdir] <manifest>\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t threads = std::thread::hardware_concurrency();
+	std::string outdir;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:o:")) != -1) {
+		switch (opt) {
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'o':
+				outdir = optarg;
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc - 1) {
+		usage();
+	}
+
+	std::vector<Job> jobs;
+	if (!read_manifest(argv[optind], jobs)) {
+		return EXIT_FAILURE;
+	}
+
+	threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+	Pool(jobs, threads).run();
+
+	// report in manifest order, however the jobs were run
+	bool ok = true;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		const Job& job = jobs[i];
+
+		printf("%zu %-6s %12llu cycles %12llu insns %8zu bytes  %s %s\n",
+			i + 1, status_name[job.status],
+			(unsigned long long)job.cycles,
+			(unsigned long long)job.instructions,
+			job.output.size(), job.rom.c_str(), job.input.c_str());
+
+		if (job.status == Job::failed) {
+			ok = false;
+		}
+		if (!outdir.empty() && !write_output(outdir, i + 1, job)) {
+			ok = false;
+		}
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
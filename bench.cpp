@@ -0,0 +1,376 @@
+//
+//	bench.cpp
+//
+//	Measures how fast each CPU emulates a set of fixed guest
+//	workloads, writing the results to stdout as JSON
+//
+//	usim-bench [-c cycles] [-r repeats] [-p] [-b baseline] [-t percent]
+//
+//	Each workload runs for the given number of guest cycles, the
+//	fastest of the repeats being reported. With -b, the results are
+//	compared with those in an earlier output, failing if any has lost
+//	more than the given percentage of its instructions per second.
+//
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "mc6809.h"
+#include "hd6309.h"
+#include "mc6850.h"
+#include "memory.h"
+#include "script.h"
+
+//---------------------------------------------------------------------
+//
+// workloads, running from $E000 with RAM below $4000
+//
+//---------------------------------------------------------------------
+
+static const Byte arith[] = {
+	0x10, 0xce, 0x40, 0x00,		// 	LDS	#$4000
+	0x10, 0x8e, 0x00, 0x00,		// 	LDY	#0
+	0x8e, 0x00, 0x64,		// loop	LDX	#100
+	0xcc, 0x12, 0x34,		// inner	LDD	#$1234
+	0xc3, 0x01, 0x01,		// 	ADDD	#$0101
+	0x8b, 0x05,			// 	ADDA	#5
+	0xc0, 0x07,			// 	SUBB	#7
+	0x3d,				// 	MUL
+	0x84, 0x30,			// 	ANDA	#$30
+	0xca, 0x01,			// 	ORB	#1
+	0x58,				// 	ASLB
+	0x49,				// 	ROLA
+	0x44,				// 	LSRA
+	0x56,				// 	RORB
+	0x88, 0x1f,			// 	EORA	#$1F
+	0x89, 0x03,			// 	ADCA	#3
+	0xc2, 0x02,			// 	SBCB	#2
+	0x40,				// 	NEGA
+	0x53,				// 	COMB
+	0x1d,				// 	SEX
+	0x83, 0x01, 0x23,		// 	SUBD	#$0123
+	0x30, 0x1f,			// 	LEAX	-1,X
+	0x26, 0xdd,			// 	BNE	inner
+	0x31, 0x21,			// 	LEAY	1,Y
+	0x10, 0x9f, 0x10,		// 	STY	$10
+	0x20, 0xd3,			// 	BRA	loop
+};
+
+static const Byte indexed[] = {
+	0x10, 0xce, 0x40, 0x00,		// 	LDS	#$4000
+	0xce, 0x20, 0x00,		// 	LDU	#$2000
+	0x8e, 0x10, 0x00,		// loop	LDX	#$1000
+	0x10, 0x8e, 0x18, 0x00,		// 	LDY	#$1800
+	0x86, 0x40,			// 	LDA	#64
+	0x97, 0x20,			// 	STA	$20
+	0xa6, 0x80,			// inner	LDA	,X+
+	0xab, 0x21,			// 	ADDA	1,Y
+	0xa7, 0xa0,			// 	STA	,Y+
+	0xec, 0x81,			// 	LDD	,X++
+	0xed, 0x42,			// 	STD	2,U
+	0xe6, 0xc6,			// 	LDB	A,U
+	0xe7, 0x3d,			// 	STB	-3,Y
+	0x30, 0x1f,			// 	LEAX	-1,X
+	0xec, 0xc9, 0x01, 0x00,		// 	LDD	$0100,U
+	0xed, 0x10,			// 	STD	-16,X
+	0x0a, 0x20,			// 	DEC	$20
+	0x26, 0xe6,			// 	BNE	inner
+	0x20, 0xd9,			// 	BRA	loop
+};
+
+static const Byte stack[] = {
+	0x10, 0xce, 0x40, 0x00,		// 	LDS	#$4000
+	0xce, 0x30, 0x00,		// 	LDU	#$3000
+	0x34, 0x76,			// loop	PSHS	A,B,X,Y,U
+	0x36, 0x36,			// 	PSHU	A,B,X,Y
+	0x8d, 0x08,			// 	BSR	sub
+	0x37, 0x36,			// 	PULU	A,B,X,Y
+	0x35, 0x76,			// 	PULS	A,B,X,Y,U
+	0x30, 0x01,			// 	LEAX	1,X
+	0x20, 0xf2,			// 	BRA	loop
+	0x34, 0x0f,			// sub	PSHS	CC,A,B,DP
+	0x17, 0x00, 0x03,		// 	LBSR	sub2
+	0x35, 0x0f,			// 	PULS	CC,A,B,DP
+	0x39,				// 	RTS
+	0x34, 0x30,			// sub2	PSHS	X,Y
+	0x35, 0xb0,			// 	PULS	X,Y,PC
+};
+
+// the ACIA interrupts whenever it's ready to send another byte
+static const Byte interrupts[] = {
+	0x10, 0xce, 0x40, 0x00,		// 	LDS	#$4000
+	0x86, 0x03,			// 	LDA	#$03
+	0xb7, 0xc0, 0x00,		// 	STA	$C000
+	0x86, 0x35,			// 	LDA	#$35
+	0xb7, 0xc0, 0x00,		// 	STA	$C000
+	0x1c, 0xef,			// 	ANDCC	#$EF
+	0x30, 0x01,			// loop	LEAX	1,X
+	0x9f, 0x10,			// 	STX	$10
+	0x20, 0xfa,			// 	BRA	loop
+	0x5c,				// irq	INCB
+	0xf7, 0xc0, 0x01,		// 	STB	$C001
+	0x3b,				// 	RTI
+};
+
+static const char tbasic_program[] =
+	"10 I=1\n"
+	"20 PRINT I*I,I/3,-I\n"
+	"30 I=I+1\n"
+	"40 IF I<30000 GOTO 20\n"
+	"50 END\n"
+	"RUN\n";
+
+struct Workload {
+	const char*		name;
+	const Byte*		code;		// or tbasic from tests/, if null
+	size_t			size;
+	Word			irq;		// handler address, if any
+};
+
+static const Workload workloads[] = {
+	{ "tbasic",		nullptr,	0,			0 },
+	{ "arith",		arith,		sizeof arith,		0 },
+	{ "indexed",		indexed,	sizeof indexed,		0 },
+	{ "stack",		stack,		sizeof stack,		0 },
+	{ "interrupts",		interrupts,	sizeof interrupts,	0xe016 },
+};
+
+//---------------------------------------------------------------------
+//
+// running and timing
+//
+//---------------------------------------------------------------------
+
+struct Result {
+	std::string		name;
+	std::string		cpu;
+	Cycles			cycles;
+	uint64_t		instructions;
+	double			seconds;
+
+	double			ips() const { return instructions / seconds; };
+};
+
+static const char *tbasic_file = "tests/tbasic.hex";
+
+// Builds a fresh machine for each repeat, timing only its run
+template<class CPU>
+static bool run(const Workload& w, const char* cpu_name, Cycles budget, int repeats, bool predecode, Result& result)
+{
+	result = { w.name, cpu_name, 0, 0, 0 };
+
+	for (int i = 0; i < repeats; ++i) {
+		CPU			cpu;
+		Script			script;
+		bool			failed = false;
+		std::vector<Byte>	image(0x2000, 0xff);
+		Word			reset = 0xe000;
+
+		auto ram = std::make_shared<RAM>(0x4000);
+		auto acia = std::make_shared<mc6850>(script, 100);
+
+		cpu.attach(ram, 0x0000, 0xc000);
+		cpu.attach(acia, 0xc000, 0xfffe);
+
+		if (w.code) {
+			memcpy(image.data(), w.code, w.size);
+		} else {
+			if (access(tbasic_file, R_OK) != 0) {
+				perror(tbasic_file);
+				return false;
+			}
+			auto rom = std::make_shared<ROM>(0x1000);
+			rom->load_intelhex(tbasic_file, 0x7000);
+			cpu.attach(rom, 0x7000, 0xf000);
+			script.type(tbasic_program);
+			reset = 0x7000;
+		}
+
+		image[0x1ff8] = w.irq >> 8;
+		image[0x1ff9] = w.irq & 0xff;
+		image[0x1ffe] = reset >> 8;
+		image[0x1fff] = reset & 0xff;
+		cpu.attach(std::make_shared<ROM_Data>(image.data(), image.size()), 0xe000, 0xe000);
+
+		acia->IRQ_line.connect(cpu.IRQ_line);
+
+		cpu.abort = [&]() {
+			failed = true;
+			cpu.halt();
+		};
+
+		if (predecode) {
+			cpu.predecode_on();
+		}
+		cpu.reset();
+
+		auto start = std::chrono::steady_clock::now();
+		cpu.run_for(budget);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (failed || cpu.cycle_count() < budget) {
+			fprintf(stderr, "%s on %s stopped early\n", w.name, cpu_name);
+			return false;
+		}
+
+		if (i == 0 || elapsed.count() < result.seconds) {
+			result.cycles = cpu.cycle_count();
+			result.instructions = cpu.instruction_count();
+			result.seconds = elapsed.count();
+		}
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------
+//
+// results, one per line so that a baseline is easily read back
+//
+//---------------------------------------------------------------------
+
+static void write_results(const std::vector<Result>& results)
+{
+	printf("{\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		printf("    { \"name\": \"%s\", \"cpu\": \"%s\", \"cycles\": %" PRIu64
+			", \"instructions\": %" PRIu64 ", \"seconds\": %.6f"
+			", \"ns_per_instruction\": %.3f, \"emulated_mhz\": %.3f"
+			", \"instructions_per_sec\": %.0f }%s\n",
+			r.name.c_str(), r.cpu.c_str(), r.cycles, r.instructions, r.seconds,
+			r.seconds * 1e9 / r.instructions, r.cycles / r.seconds / 1e6,
+			r.ips(), i + 1 < results.size() ? "," : "");
+	}
+	printf("  ]\n}\n");
+}
+
+// Finds "key": in a line of the results, returning what follows
+static const char* field(const char* line, const char* key)
+{
+	std::string quoted = std::string("\"") + key + "\":";
+	const char* p = strstr(line, quoted.c_str());
+	if (!p) {
+		return nullptr;
+	}
+	p += quoted.size();
+	while (*p == ' ' || *p == '"') ++p;
+	return p;
+}
+
+static bool same_string(const char* p, const std::string& s)
+{
+	return p && strncmp(p, s.c_str(), s.size()) == 0 && p[s.size()] == '"';
+}
+
+// Returns false if any result is slower than its baseline by more
+// than `threshold` percent, reporting each comparison to stderr
+static bool compare(const std::vector<Result>& results, const char* filename, double threshold)
+{
+	FILE* fp = fopen(filename, "r");
+	if (!fp) {
+		perror(filename);
+		return false;
+	}
+
+	std::vector<std::string> lines;
+	char buf[512];
+	while (fgets(buf, sizeof buf, fp)) {
+		lines.push_back(buf);
+	}
+	fclose(fp);
+
+	bool ok = true;
+	for (const Result& r : results) {
+		double base = 0;
+		for (auto& line : lines) {
+			const char* p = line.c_str();
+			const char* ips = field(p, "instructions_per_sec");
+			if (ips && same_string(field(p, "name"), r.name) && same_string(field(p, "cpu"), r.cpu)) {
+				base = strtod(ips, NULL);
+				break;
+			}
+		}
+		if (base <= 0) {
+			fprintf(stderr, "%-12s %s: not in baseline\n", r.name.c_str(), r.cpu.c_str());
+			continue;
+		}
+
+		double change = 100.0 * (r.ips() - base) / base;
+		bool regressed = change < -threshold;
+		fprintf(stderr, "%-12s %s: %12.0f vs %12.0f instructions/sec, %+6.1f%%%s\n",
+			r.name.c_str(), r.cpu.c_str(), r.ips(), base, change,
+			regressed ? "  REGRESSED" : "");
+		ok = ok && !regressed;
+	}
+
+	return ok;
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: usim-bench [-c cycles] [-r repeats] [-p] [-b baseline] [-t percent]\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	Cycles budget = 20000000;
+	int repeats = 3;
+	bool predecode = false;
+	const char* baseline = nullptr;
+	double threshold = 5.0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:r:pb:t:")) != -1) {
+		switch (opt) {
+			case 'c':
+				budget = strtoull(optarg, NULL, 0);
+				break;
+			case 'r':
+				repeats = atoi(optarg);
+				break;
+			case 'p':
+				predecode = true;
+				break;
+			case 'b':
+				baseline = optarg;
+				break;
+			case 't':
+				threshold = strtod(optarg, NULL);
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc || budget == 0 || repeats < 1) {
+		usage();
+	}
+
+	std::vector<Result> results;
+	for (const Workload& w : workloads) {
+		Result r;
+		if (!run<mc6809>(w, "mc6809", budget, repeats, predecode, r)) {
+			return EXIT_FAILURE;
+		}
+		results.push_back(r);
+		if (!run<hd6309>(w, "hd6309", budget, repeats, predecode, r)) {
+			return EXIT_FAILURE;
+		}
+		results.push_back(r);
+	}
+
+	write_results(results);
+
+	if (baseline && !compare(results, baseline, threshold)) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -11,16 +11,119 @@
 #include <memory>
 #include <vector>
 #include <functional>
+#include <cstring>
+#include <type_traits>
 #include "typedefs.h"
 
+/*
+ * the saved state of a CPU or device, as a flat run of values
+ * that must be read back in the same order they were written
+ */
+class StateBuffer {
+
+	friend class StateReader;
+
+protected:
+	std::vector<Byte>	data;
+
+public:
+	template<typename T>
+	void			put(const T& val) {
+					static_assert(std::is_trivially_copyable<T>::value, "can't save that");
+					put(reinterpret_cast<const Byte*>(&val), sizeof(T));
+				}
+
+	void			put(const Byte* p, size_t len) {
+					data.insert(data.end(), p, p + len);
+				}
+};
+
+class StateReader {
+
+protected:
+	const StateBuffer&	buf;
+	size_t			pos = 0;
+
+public:
+				StateReader(const StateBuffer& buf) : buf(buf) {};
+
+	template<typename T>
+	void			get(T& val) {
+					static_assert(std::is_trivially_copyable<T>::value, "can't restore that");
+					get(reinterpret_cast<Byte*>(&val), sizeof(T));
+				}
+
+	void			get(Byte* p, size_t len) {
+					memcpy(p, buf.data.data() + pos, len);
+					pos += len;
+				}
+};
+
+/*
+ * anything whose state can be included in a machine snapshot
+ */
+class Stateful {
+
+public:
+	virtual void		save(StateBuffer& state) const {
+					(void)state;
+				}
+
+	virtual void		restore(StateReader& state) {
+					(void)state;
+				}
+
+public:
+	virtual			~Stateful() {};
+};
+
+/*
+ * the system timebase, counted in CPU cycles, and the earliest
+ * time at which any attached ActiveDevice next needs a tick
+ */
+struct Clock {
+	Cycles				now = 0;
+	Cycles				next_event = 0;
+};
+
 /*
  * an abstract device that responds to CPU cycle ticks and might be reset
  */
-class ActiveDevice {
+class ActiveDevice : virtual public Stateful {
 
 public:
 	virtual void		reset() = 0;
-	virtual void		tick(uint8_t cycles) = 0;
+	virtual void		tick(Cycles now) = 0;
+
+	// the CPU can do nothing until this device's next tick, so a
+	// device fed from the outside world may block the host here
+	// until it has something to report
+	virtual void		idle() {};
+
+// tick() is only called once the clock reaches the time last passed
+// to wake_at(), so a device that never calls it is ticked after
+// every instruction
+public:
+	Cycles			wakeup = 0;
+
+	void			set_clock(Clock* c) {
+					clock = c;
+					wake_at(wakeup);
+				}
+
+protected:
+	Clock*			clock = nullptr;
+
+	Cycles			now() const {
+					return clock ? clock->now : 0;
+				}
+
+	void			wake_at(Cycles when) {
+					wakeup = when;
+					if (clock && when < clock->next_event) {
+						clock->next_event = when;
+					}
+				}
 
 public:
 	using shared_ptr = std::shared_ptr<ActiveDevice>;
@@ -31,12 +134,36 @@ public:
 /*
  * an abstract memory mapped device
  */
-class MappedDevice {
+class MappedDevice : virtual public Stateful {
 
 public:
 	virtual Byte		read(Word offset) = 0;
 	virtual void		write(Word offset, Byte val) = 0;
 
+// Direct access to the host memory backing [offset, offset + len),
+// for devices that are plain memory with no side effects on access.
+// Returns nullptr if accesses must go through read() and write().
+public:
+	virtual const Byte*	read_ptr(Word offset, size_t len) {
+					(void)offset;
+					(void)len;
+					return nullptr;
+				}
+
+	virtual Byte*		write_ptr(Word offset, size_t len) {
+					(void)offset;
+					(void)len;
+					return nullptr;
+				}
+
+// Whether reading `offset` leaves the device unchanged, so that
+// a guest loop that only polls it may be fast-forwarded
+public:
+	virtual bool		read_is_passive(Word offset) {
+					(void)offset;
+					return false;
+				}
+
 public:
 	using shared_ptr = std::shared_ptr<MappedDevice>;
 
@@ -72,6 +199,21 @@ struct ActiveDeviceEntry {
 typedef std::vector<ActiveDeviceEntry> ActiveDevList;
 typedef std::vector<MappedDeviceEntry> MappedDevList;
 
+/*
+ * a 256 byte page of the address space, resolved to the single
+ * MappedDevice that answers for every address within it, or to
+ * nullptr if the page is unmapped or shared between devices
+ *
+ * if that device is plain memory then `read` and / or `write`
+ * point directly at the host memory backing the page
+ */
+struct MappedPage {
+	MappedDevice*			device;
+	Word				base;
+	const Byte*			read;
+	Byte*				write;
+};
+
 /*
  * template to resolve smart point ambiguity issues
  * see https://stackoverflow.com/questions/66032442/
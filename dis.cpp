@@ -0,0 +1,87 @@
+//
+//	dis.cpp
+//
+//	Disassembles a ROM image, as loaded by usim: Intel hex or DECB,
+//	mapped from the base address up to the top of memory
+//
+
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+
+#include "disasm.h"
+#include "memory.h"
+
+static void usage()
+{
+	fprintf(stderr, "usage: usim-dis [-3] [-b base] [-s start] [-e end] <romfile>\n"
+			"  -3        the 6309 instruction set\n"
+			"  -b base   where the ROM starts, in hex (c000)\n"
+			"  -s start  where to start disassembling, in hex (the base)\n"
+			"  -e end    where to stop, in hex (ffff)\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	Disassembler::instruction_set set = Disassembler::mc6809_set;
+	DWord base = 0xc000;
+	DWord start = 0;
+	DWord end = 0xffff;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "3b:s:e:")) != -1) {
+		switch (opt) {
+			case '3':
+				set = Disassembler::hd6309_set;
+				break;
+			case 'b':
+				base = strtoul(optarg, NULL, 16);
+				break;
+			case 's':
+				start = strtoul(optarg, NULL, 16);
+				break;
+			case 'e':
+				end = strtoul(optarg, NULL, 16);
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc - 1 || base > 0xffff || end > 0xffff) {
+		usage();
+	}
+
+	ROM rom(0x10000 - base);
+	rom.load(argv[optind], base);
+
+	const Byte* mem = rom.read_ptr(0, 0x10000 - base);
+	Disassembler disasm(set);
+	Disassembly insn;
+
+	for (DWord pc = (start > base) ? start : base; pc <= end; ) {
+		const Byte* code = mem + (pc - base);
+		Byte len = disasm.decode(code, 0x10000 - pc, pc, insn);
+
+		// an instruction running off the end of memory
+		if (!len) {
+			insn.mnemonic = "FCB";
+			snprintf(insn.operand, sizeof insn.operand, "$%02X", *code);
+			len = 1;
+		}
+
+		printf("%04X  ", pc);
+		for (int i = 0; i < 5; ++i) {
+			if (i < len) {
+				printf("%02X ", code[i]);
+			} else {
+				printf("   ");
+			}
+		}
+		printf(" %-8s%s\n", insn.mnemonic, insn.operand);
+
+		pc += len;
+	}
+
+	return EXIT_SUCCESS;
+}
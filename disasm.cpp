@@ -0,0 +1,770 @@
+//
+//	disasm.cpp
+//
+
+#include <cstring>
+#include <vector>
+#include "disasm.h"
+
+namespace {
+
+using opcode = Disassembler::opcode;
+
+// One row each of inherent, direct, indexed and extended
+// read-modify-write instructions, with the accumulator versions
+// named separately as they're not all just "A" or "B" appended
+const char* rmw[16] = {
+	"NEG", nullptr, nullptr, "COM", "LSR", nullptr, "ROR", "ASR",
+	"LSL", "ROL", "DEC", nullptr, "INC", "TST", "JMP", "CLR"
+};
+
+const char* const regs_6809[16] = {
+	"D", "X", "Y", "U", "S", "PC", "?", "?",
+	"A", "B", "CC", "DP", "?", "?", "?", "?"
+};
+
+const char* const regs_6309[16] = {
+	"D", "X", "Y", "U", "S", "PC", "W", "V",
+	"A", "B", "CC", "DP", "0", "0", "E", "F"
+};
+
+// Formatting straight into the operand buffer, which is big
+// enough for the longest operand that any instruction has
+
+inline void put(char*& out, const char* s)
+{
+	while (*s) {
+		*out++ = *s++;
+	}
+}
+
+// The two hex digits of every byte
+struct hex_pairs {
+	char	digits[256][2];
+
+	constexpr hex_pairs() : digits()
+	{
+		const char hex[] = "0123456789ABCDEF";
+		for (int n = 0; n < 256; ++n) {
+			digits[n][0] = hex[n >> 4];
+			digits[n][1] = hex[n & 0x0f];
+		}
+	}
+};
+
+constexpr hex_pairs hex;
+
+// Writes four digits, left aligned, so that how many are shown
+// costs no branches; the operand buffer has room for the rest
+inline void write_hex(char* out, Word val, int digits)
+{
+	Word left = (uint32_t)val << (16 - 4 * digits);
+
+	out[0] = '$';
+	memcpy(out + 1, hex.digits[left >> 8], 2);
+	memcpy(out + 3, hex.digits[left & 0xff], 2);
+}
+
+inline void put_hex(char*& out, uint32_t val, int digits)
+{
+	*out++ = '$';
+	for (int shift = (digits - 2) * 4; shift >= 0; shift -= 8) {
+		memcpy(out, hex.digits[(val >> shift) & 0xff], 2);
+		out += 2;
+	}
+}
+
+inline void put_dec(char*& out, int val)
+{
+	char digits[8];
+	int n = 0;
+
+	if (val < 0) {
+		*out++ = '-';
+		val = -val;
+	}
+	do {
+		digits[n++] = '0' + val % 10;
+		val /= 10;
+	} while (val);
+	while (n) {
+		*out++ = digits[--n];
+	}
+}
+
+// The kinds of offset following an indexed postbyte
+enum : Byte {
+	no_offset,
+	offset8, offset16,		// shown in decimal
+	pcr8, pcr16,			// shown as the address they refer to
+	address				// [Address]
+};
+
+// What the simpler operands show, if anything, as a single hex value
+enum : Byte {
+	operand_value,
+	branch_target,
+	opcode_byte			// for an illegal opcode
+};
+
+// The simpler operands show at most one value, perhaps after a
+// postbyte, and share one path with no branches for a mispredicted
+// mode to cost
+struct layout {
+	bool		simple;
+	Byte		skip;		// operand bytes before the value
+	Byte		bytes;		// in the value
+	Byte		shows;
+	char		prefix;
+	Byte		digits;
+};
+
+// the rest are formatted one by one
+constexpr layout elsewhere = { false, 0, 0, operand_value, 0, 0 };
+
+constexpr layout layouts[] = {
+	{ true, 0, 0, opcode_byte, 0, 2 },	// illegal
+	elsewhere,				// prefix
+	{ true, 0, 0, operand_value, 0, 0 },	// inherent
+	{ true, 0, 1, operand_value, '#', 2 },	// imm8
+	{ true, 0, 2, operand_value, '#', 4 },	// imm16
+	elsewhere,				// imm32
+	{ true, 0, 1, operand_value, '<', 2 },	// direct
+	{ true, 0, 2, operand_value, 0, 4 },	// extended
+	{ false, 1, 0, operand_value, 0, 0 },	// indexed, laid out by the postbyte
+	{ true, 0, 1, branch_target, 0, 4 },	// rel8
+	{ true, 0, 2, branch_target, 0, 4 },	// rel16
+	elsewhere, elsewhere, elsewhere,	// regpair, reglist_s, reglist_u
+	elsewhere, elsewhere, elsewhere, elsewhere,	// tfm_pp to tfm_np
+	elsewhere,				// bitop
+	elsewhere, elsewhere, elsewhere		// imm_direct to imm_extended
+};
+
+static_assert(sizeof layouts / sizeof layouts[0] == Disassembler::imm_extended + 1,
+	"a layout for every mode");
+
+// The same for the offset after each kind of indexed postbyte, with
+// decimal offsets formatted one by one
+constexpr layout offsets[] = {
+	{ true, 1, 0, operand_value, 0, 0 },	// no_offset
+	{ false, 1, 1, operand_value, 0, 0 },	// offset8
+	{ false, 1, 2, operand_value, 0, 0 },	// offset16
+	{ true, 1, 1, branch_target, 0, 4 },	// pcr8
+	{ true, 1, 2, branch_target, 0, 4 },	// pcr16
+	{ true, 1, 2, operand_value, 0, 4 }	// address
+};
+
+} // namespace
+
+struct Disassembler::postbyte {
+	layout		shape;		// of the offset
+	Byte		offset;		// the kind of offset
+	char		text[8];	// what follows the offset
+	Byte		length;
+};
+
+//----------------------------------------------------------------------------
+
+// Fills `names` across the immediate, direct, indexed and extended
+// rows starting at `base`, with immediates 16 bits wide for the
+// columns set in `wide`, and with no immediate for those in `none`
+void Disassembler::block(opcode* t, Byte base, const char* const names[16], uint16_t wide, uint16_t none)
+{
+	for (int col = 0; col < 16; ++col) {
+		if (!names[col]) continue;
+		uint16_t bit = 1 << col;
+
+		if (!(none & bit)) {
+			t[base + col] = { names[col], (wide & bit) ? imm16 : imm8 };
+		}
+		t[base + 0x10 + col] = { names[col], direct };
+		t[base + 0x20 + col] = { names[col], indexed };
+		t[base + 0x30 + col] = { names[col], extended };
+	}
+}
+
+void Disassembler::inherent_row(opcode* t, Byte base, const char* const names[16])
+{
+	for (int col = 0; col < 16; ++col) {
+		if (names[col]) {
+			t[base + col] = { names[col], inherent };
+		}
+	}
+}
+
+void Disassembler::fill_6809(opcode* t)
+{
+	opcode* p10 = t + 256;
+	opcode* p11 = t + 512;
+
+	for (int col = 0; col < 16; ++col) {
+		if (!rmw[col]) continue;
+		t[0x00 + col] = { rmw[col], direct };
+		t[0x60 + col] = { rmw[col], indexed };
+		t[0x70 + col] = { rmw[col], extended };
+	}
+
+	static const char* const rmw_a[16] = {
+		"NEGA", nullptr, nullptr, "COMA", "LSRA", nullptr, "RORA", "ASRA",
+		"LSLA", "ROLA", "DECA", nullptr, "INCA", "TSTA", nullptr, "CLRA"
+	};
+	static const char* const rmw_b[16] = {
+		"NEGB", nullptr, nullptr, "COMB", "LSRB", nullptr, "RORB", "ASRB",
+		"LSLB", "ROLB", "DECB", nullptr, "INCB", "TSTB", nullptr, "CLRB"
+	};
+	inherent_row(t, 0x40, rmw_a);
+	inherent_row(t, 0x50, rmw_b);
+
+	t[0x10] = { "", prefix };
+	t[0x11] = { "", prefix };
+	t[0x12] = { "NOP", inherent };
+	t[0x13] = { "SYNC", inherent };
+	t[0x16] = { "LBRA", rel16 };
+	t[0x17] = { "LBSR", rel16 };
+	t[0x19] = { "DAA", inherent };
+	t[0x1a] = { "ORCC", imm8 };
+	t[0x1c] = { "ANDCC", imm8 };
+	t[0x1d] = { "SEX", inherent };
+	t[0x1e] = { "EXG", regpair };
+	t[0x1f] = { "TFR", regpair };
+
+	static const char* const branches[16] = {
+		"BRA", "BRN", "BHI", "BLS", "BCC", "BCS", "BNE", "BEQ",
+		"BVC", "BVS", "BPL", "BMI", "BGE", "BLT", "BGT", "BLE"
+	};
+	static const char* const long_branches[16] = {
+		nullptr, "LBRN", "LBHI", "LBLS", "LBCC", "LBCS", "LBNE", "LBEQ",
+		"LBVC", "LBVS", "LBPL", "LBMI", "LBGE", "LBLT", "LBGT", "LBLE"
+	};
+	for (int col = 0; col < 16; ++col) {
+		t[0x20 + col] = { branches[col], rel8 };
+		if (long_branches[col]) {
+			p10[0x20 + col] = { long_branches[col], rel16 };
+		}
+	}
+
+	t[0x30] = { "LEAX", indexed };
+	t[0x31] = { "LEAY", indexed };
+	t[0x32] = { "LEAS", indexed };
+	t[0x33] = { "LEAU", indexed };
+	t[0x34] = { "PSHS", reglist_s };
+	t[0x35] = { "PULS", reglist_s };
+	t[0x36] = { "PSHU", reglist_u };
+	t[0x37] = { "PULU", reglist_u };
+	t[0x39] = { "RTS", inherent };
+	t[0x3a] = { "ABX", inherent };
+	t[0x3b] = { "RTI", inherent };
+	t[0x3c] = { "CWAI", imm8 };
+	t[0x3d] = { "MUL", inherent };
+	t[0x3f] = { "SWI", inherent };
+
+	static const char* const acc_a[16] = {
+		"SUBA", "CMPA", "SBCA", "SUBD", "ANDA", "BITA", "LDA", "STA",
+		"EORA", "ADCA", "ORA", "ADDA", "CMPX", "JSR", "LDX", "STX"
+	};
+	static const char* const acc_b[16] = {
+		"SUBB", "CMPB", "SBCB", "ADDD", "ANDB", "BITB", "LDB", "STB",
+		"EORB", "ADCB", "ORB", "ADDB", "LDD", "STD", "LDU", "STU"
+	};
+	block(t, 0x80, acc_a, 0x5008, 0xa080);
+	block(t, 0xc0, acc_b, 0x5008, 0xa080);
+	t[0x8d] = { "BSR", rel8 };
+
+	static const char* const page10[16] = {
+		nullptr, nullptr, nullptr, "CMPD", nullptr, nullptr, nullptr, nullptr,
+		nullptr, nullptr, nullptr, nullptr, "CMPY", nullptr, "LDY", "STY"
+	};
+	static const char* const page10_s[16] = {
+		nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+		nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "LDS", "STS"
+	};
+	block(p10, 0x80, page10, 0x5008, 0x8000);
+	block(p10, 0xc0, page10_s, 0x4000, 0x8000);
+	p10[0x3f] = { "SWI2", inherent };
+
+	static const char* const page11[16] = {
+		nullptr, nullptr, nullptr, "CMPU", nullptr, nullptr, nullptr, nullptr,
+		nullptr, nullptr, nullptr, nullptr, "CMPS", nullptr, nullptr, nullptr
+	};
+	block(p11, 0x80, page11, 0x1008, 0);
+	p11[0x3f] = { "SWI3", inherent };
+}
+
+void Disassembler::fill_6309(opcode* t)
+{
+	opcode* p10 = t + 256;
+	opcode* p11 = t + 512;
+
+	fill_6809(t);
+
+	static const char* const imm_ops[4] = { "OIM", "AIM", "EIM", "TIM" };
+	static const Byte imm_cols[4] = { 0x01, 0x02, 0x05, 0x0b };
+	for (int i = 0; i < 4; ++i) {
+		t[0x00 + imm_cols[i]] = { imm_ops[i], imm_direct };
+		t[0x60 + imm_cols[i]] = { imm_ops[i], imm_indexed };
+		t[0x70 + imm_cols[i]] = { imm_ops[i], imm_extended };
+	}
+	t[0x14] = { "SEXW", inherent };
+	t[0xcd] = { "LDQ", imm32 };
+
+	static const char* const reg_ops[8] = {
+		"ADDR", "ADCR", "SUBR", "SBCR", "ANDR", "ORR", "EORR", "CMPR"
+	};
+	for (int i = 0; i < 8; ++i) {
+		p10[0x30 + i] = { reg_ops[i], regpair };
+	}
+	p10[0x38] = { "PSHSW", inherent };
+	p10[0x39] = { "PULSW", inherent };
+	p10[0x3a] = { "PSHUW", inherent };
+	p10[0x3b] = { "PULUW", inherent };
+
+	static const char* const rmw_d[16] = {
+		"NEGD", nullptr, nullptr, "COMD", "LSRD", nullptr, "RORD", "ASRD",
+		"LSLD", "ROLD", "DECD", nullptr, "INCD", "TSTD", nullptr, "CLRD"
+	};
+	static const char* const rmw_w[16] = {
+		nullptr, nullptr, nullptr, "COMW", "LSRW", nullptr, "RORW", nullptr,
+		nullptr, "ROLW", "DECW", nullptr, "INCW", "TSTW", nullptr, "CLRW"
+	};
+	inherent_row(p10, 0x40, rmw_d);
+	inherent_row(p10, 0x50, rmw_w);
+
+	static const char* const page10[16] = {
+		"SUBW", "CMPW", "SBCD", "CMPD", "ANDD", "BITD", "LDW", "STW",
+		"EORD", "ADCD", "ORD", "ADDW", "CMPY", nullptr, "LDY", "STY"
+	};
+	static const char* const page10_q[16] = {
+		nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+		nullptr, nullptr, nullptr, nullptr, "LDQ", "STQ", "LDS", "STS"
+	};
+	block(p10, 0x80, page10, 0xffff, 0x8080);
+	block(p10, 0xc0, page10_q, 0x4000, 0xb000);
+
+	static const char* const bit_ops[8] = {
+		"BAND", "BIAND", "BOR", "BIOR", "BEOR", "BIEOR", "LDBT", "STBT"
+	};
+	for (int i = 0; i < 8; ++i) {
+		p11[0x30 + i] = { bit_ops[i], bitop };
+	}
+	p11[0x38] = { "TFM", tfm_pp };
+	p11[0x39] = { "TFM", tfm_mm };
+	p11[0x3a] = { "TFM", tfm_pn };
+	p11[0x3b] = { "TFM", tfm_np };
+	p11[0x3c] = { "BITMD", imm8 };
+	p11[0x3d] = { "LDMD", imm8 };
+
+	static const char* const rmw_e[16] = {
+		nullptr, nullptr, nullptr, "COME", nullptr, nullptr, nullptr, nullptr,
+		nullptr, nullptr, "DECE", nullptr, "INCE", "TSTE", nullptr, "CLRE"
+	};
+	static const char* const rmw_f[16] = {
+		nullptr, nullptr, nullptr, "COMF", nullptr, nullptr, nullptr, nullptr,
+		nullptr, nullptr, "DECF", nullptr, "INCF", "TSTF", nullptr, "CLRF"
+	};
+	inherent_row(p11, 0x40, rmw_e);
+	inherent_row(p11, 0x50, rmw_f);
+
+	static const char* const page11_e[16] = {
+		"SUBE", "CMPE", nullptr, "CMPU", nullptr, nullptr, "LDE", "STE",
+		nullptr, nullptr, nullptr, "ADDE", "CMPS", "DIVD", "DIVQ", "MULD"
+	};
+	static const char* const page11_f[16] = {
+		"SUBF", "CMPF", nullptr, nullptr, nullptr, nullptr, "LDF", "STF",
+		nullptr, nullptr, nullptr, "ADDF", nullptr, nullptr, nullptr, nullptr
+	};
+	block(p11, 0x80, page11_e, 0xd008, 0x0080);
+	block(p11, 0xc0, page11_f, 0x0000, 0x0080);
+}
+
+const opcode* Disassembler::table_6809()
+{
+	static const std::vector<opcode> table = [] {
+		std::vector<opcode> t(3 * 256, { "FCB", illegal });
+		fill_6809(t.data());
+		return t;
+	}();
+
+	return table.data();
+}
+
+const opcode* Disassembler::table_6309()
+{
+	static const std::vector<opcode> table = [] {
+		std::vector<opcode> t(3 * 256, { "FCB", illegal });
+		fill_6309(t.data());
+		return t;
+	}();
+
+	return table.data();
+}
+
+Disassembler::Disassembler(instruction_set set)
+	: set(set),
+	  table(set == hd6309_set ? table_6309() : table_6809()),
+	  postbytes(set == hd6309_set ? postbytes_6309() : postbytes_6809())
+{
+	// apart from the mode, so they're read alongside it when decoding
+	for (int ir = 0; ir < 3 * 256; ++ir) {
+		const layout& form = layouts[table[ir].mode];
+		operand_bytes[ir] = form.skip + form.bytes;
+	}
+}
+
+const opcode& Disassembler::lookup(Word ir) const
+{
+	Byte page = (ir >> 8) == 0x10 ? 1 : (ir >> 8) == 0x11 ? 2 : 0;
+	return table[page * 256 + (ir & 0xff)];
+}
+
+// Formats every indexed postbyte once, leaving just any offset
+// following it to be filled in as each instruction is decoded
+void Disassembler::fill_postbytes(postbyte* t, bool native)
+{
+	static const char regs[] = "XYUS";
+
+	for (int post = 0; post < 256; ++post) {
+		postbyte& form = t[post];
+		char* out = form.text;
+		char reg[2] = { regs[(post >> 5) & 0x03], '\0' };
+
+		bool indirect = (post & 0x90) == 0x90;
+		form.offset = no_offset;
+
+		if (!(post & 0x80)) {			// ,R + 5 bit offset
+			put_dec(out, (post & 0x10) ? (post & 0x1f) - 32 : (post & 0x1f));
+			*out++ = ',';
+			put(out, reg);
+			form.shape = offsets[no_offset];
+			form.length = out - form.text;
+			continue;
+		}
+
+		switch (post & 0x1f) {
+			case 0x00:			// ,R+
+				put(out, ",");
+				put(out, reg);
+				put(out, "+");
+				break;
+			case 0x01: case 0x11:		// ,R++
+				put(out, ",");
+				put(out, reg);
+				put(out, "++");
+				break;
+			case 0x02:			// ,-R
+				put(out, ",-");
+				put(out, reg);
+				break;
+			case 0x03: case 0x13:		// ,--R
+				put(out, ",--");
+				put(out, reg);
+				break;
+			case 0x04: case 0x14:		// ,R + 0
+				put(out, ",");
+				put(out, reg);
+				break;
+			case 0x05: case 0x15:		// ,R + B
+				put(out, "B,");
+				put(out, reg);
+				break;
+			case 0x06: case 0x16:		// ,R + A
+				put(out, "A,");
+				put(out, reg);
+				break;
+			case 0x08: case 0x18:		// ,R + 8 bit
+				form.offset = offset8;
+				*out++ = ',';
+				put(out, reg);
+				break;
+			case 0x09: case 0x19:		// ,R + 16 bit
+				form.offset = offset16;
+				*out++ = ',';
+				put(out, reg);
+				break;
+			case 0x0b: case 0x1b:		// ,R + D
+				put(out, "D,");
+				put(out, reg);
+				break;
+			case 0x0c: case 0x1c:		// ,PC + 8
+				form.offset = pcr8;
+				put(out, ",PCR");
+				break;
+			case 0x0d: case 0x1d:		// ,PC + 16
+				form.offset = pcr16;
+				put(out, ",PCR");
+				break;
+			case 0x1f:			// [,Address]
+				form.offset = address;
+				break;
+			case 0x07: case 0x17:		// 6309 ,R + E
+			case 0x0a: case 0x1a:		// 6309 ,R + F
+			case 0x0e: case 0x1e:		// 6309 ,R + W
+				if (!native) goto invalid;
+				switch (post & 0x0f) {
+					case 0x07: *out++ = 'E'; break;
+					case 0x0a: *out++ = 'F'; break;
+					case 0x0e: *out++ = 'W'; break;
+				}
+				*out++ = ',';
+				put(out, reg);
+				break;
+			case 0x0f: case 0x10:		// 6309 ,W modes, with 0x10 indirect
+				if (!native) goto invalid;
+				switch (post & 0x60) {
+					case 0x00:
+						put(out, ",W");
+						break;
+					case 0x20:
+						form.offset = offset16;
+						put(out, ",W");
+						break;
+					case 0x40:
+						put(out, ",W++");
+						break;
+					case 0x60:
+						put(out, ",--W");
+						break;
+				}
+				break;
+			default:
+			invalid:
+				put(out, "??");
+				break;
+		}
+
+		if (indirect) {
+			*out++ = ']';
+		}
+		form.shape = offsets[form.offset];
+		form.shape.prefix = indirect ? '[' : 0;
+		form.length = out - form.text;
+	}
+}
+
+const Disassembler::postbyte* Disassembler::postbytes_6809()
+{
+	static const std::vector<postbyte> table = [] {
+		std::vector<postbyte> t(256);
+		fill_postbytes(t.data(), false);
+		return t;
+	}();
+
+	return table.data();
+}
+
+const Disassembler::postbyte* Disassembler::postbytes_6309()
+{
+	static const std::vector<postbyte> table = [] {
+		std::vector<postbyte> t(256);
+		fill_postbytes(t.data(), true);
+		return t;
+	}();
+
+	return table.data();
+}
+
+// Formats an indexed postbyte and any offset following it, with
+// PC relative offsets shown as the address they refer to
+bool Disassembler::decode_indexed(const Byte*& p, const Byte* end, const Byte* code, Word pc, char*& out) const
+{
+	if (p == end) return false;
+
+	const postbyte& form = postbytes[*p++];
+	if (end - p < form.shape.bytes) return false;
+
+	*out = '[';
+	out += form.shape.prefix != 0;
+
+	switch (form.offset) {
+		case no_offset:
+			break;
+		case offset8:
+			put_dec(out, (int8_t)*p++);
+			break;
+		case offset16:
+			put_dec(out, (int16_t)((p[0] << 8) | p[1]));
+			p += 2;
+			break;
+		case pcr8: {
+			int8_t offset = *p++;
+			put_hex(out, (Word)(pc + (p - code) + offset), 4);
+			break;
+		}
+		case pcr16: {
+			Word offset = (p[0] << 8) | p[1];
+			p += 2;
+			put_hex(out, (Word)(pc + (p - code) + offset), 4);
+			break;
+		}
+		case address:
+			put_hex(out, (p[0] << 8) | p[1], 4);
+			p += 2;
+			break;
+	}
+
+	memcpy(out, form.text, sizeof form.text);
+	out += form.length;
+
+	return true;
+}
+
+Byte Disassembler::decode(const Byte* code, size_t len, Word pc, Disassembly& insn) const
+{
+	const Byte* p = code;
+	const Byte* end = code + len;
+	char* out = insn.operand;
+
+	insn.length = 0;
+	insn.mnemonic = "";
+	insn.operand[0] = '\0';
+
+	if (p == end) return 0;
+
+	// the index into the tables, including the page of any prefix
+	Word ir = *p++;
+	if (table[ir].mode == prefix) {
+		if (p == end) return 0;
+		ir = (ir - 0x0f) * 256 + *p++;
+	}
+
+	const opcode& entry = table[ir];
+	insn.mnemonic = entry.mnemonic;
+
+	// the next four bytes, whichever of them are used
+	uint32_t next = 0;
+	if (end - p >= 4) {
+		next = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+	} else {
+		for (int n = 0; n < end - p; ++n) {
+			next |= p[n] << (24 - 8 * n);
+		}
+	}
+
+	// An indexed operand is laid out by its postbyte. Choices like
+	// this are made by indexing, not by branches that random code
+	// would mispredict, and the length found without waiting on them
+	bool is_indexed = entry.mode == indexed;
+	const postbyte& post = postbytes[next >> 24];
+	const layout* const forms[2] = { &layouts[entry.mode], &post.shape };
+	const layout& form = *forms[is_indexed];
+	Byte bytes = operand_bytes[ir] + (post.shape.bytes & -is_indexed);
+
+	if (!form.simple) {
+		return insn.length = decode_operand(entry.mode, code, p, end, pc, insn.operand);
+	}
+	if (end - p < bytes) return 0;
+
+	uint32_t from = next << (8 * form.skip);
+	uint32_t val = (uint64_t)from >> (32 - 8 * form.bytes);
+	int32_t offset = (int64_t)(int32_t)from >> (32 - 8 * form.bytes);
+	p += bytes;
+
+	const Word shown[] = { (Word)val, (Word)(pc + (p - code) + offset), (Byte)ir };
+
+	// an illegal opcode's prefix is shown before it
+	if (ir > 0xff && entry.mode == illegal) {
+		put_hex(out, code[0], 2);
+		*out++ = ',';
+	}
+
+	*out = form.prefix;
+	out += form.prefix != 0;
+	write_hex(out, shown[form.shows], form.digits);
+	out += form.digits + (form.digits != 0);
+
+	memcpy(out, post.text, sizeof post.text);
+	out += post.length & -is_indexed;
+
+	*out = '\0';
+	return insn.length = p - code;
+}
+
+// The operands that don't fit a layout, returning the length or
+// 0 with nothing written if they run off the end of the code
+Byte Disassembler::decode_operand(Byte mode, const Byte* code, const Byte* p, const Byte* end, Word pc, char* operand) const
+{
+	char* out = operand;
+
+	switch (mode) {
+		case imm32:
+			if (end - p < 4) goto truncated;
+			*out++ = '#';
+			put_hex(out, ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3], 8);
+			p += 4;
+			break;
+
+		case indexed:
+			if (!decode_indexed(p, end, code, pc, out)) goto truncated;
+			break;
+
+		case regpair:
+		case tfm_pp: case tfm_mm: case tfm_pn: case tfm_np: {
+			if (end - p < 1) goto truncated;
+			const char* const* regs = (set == hd6309_set) ? regs_6309 : regs_6809;
+			Byte r = *p++;
+			put(out, regs[r >> 4]);
+			if (mode == tfm_pp || mode == tfm_pn) *out++ = '+';
+			if (mode == tfm_mm) *out++ = '-';
+			*out++ = ',';
+			put(out, regs[r & 0x0f]);
+			if (mode == tfm_pp || mode == tfm_np) *out++ = '+';
+			if (mode == tfm_mm) *out++ = '-';
+			break;
+		}
+
+		case reglist_s:
+		case reglist_u: {
+			static const char* const names[8] = {
+				"CC", "A", "B", "DP", "X", "Y", nullptr, "PC"
+			};
+			if (end - p < 1) goto truncated;
+			Byte w = *p++;
+			for (int n = 0; n < 8 && w; ++n, w >>= 1) {
+				if (w & 1) {
+					put(out, names[n] ? names[n] : (mode == reglist_s) ? "U" : "S");
+					if (w & 0xfe) *out++ = ',';
+				}
+			}
+			break;
+		}
+
+		case bitop: {
+			static const char* const regs[4] = { "CC", "A", "B", "?" };
+			if (end - p < 2) goto truncated;
+			Byte post = *p++;
+			put(out, regs[post >> 6]);
+			*out++ = ',';
+			*out++ = '0' + ((post >> 3) & 0x07);
+			*out++ = ',';
+			*out++ = '0' + (post & 0x07);
+			put(out, ",<");
+			put_hex(out, *p++, 2);
+			break;
+		}
+
+		case imm_direct:
+		case imm_indexed:
+		case imm_extended:
+			if (end - p < 2) goto truncated;
+			*out++ = '#';
+			put_hex(out, *p++, 2);
+			*out++ = ',';
+			if (mode == imm_direct) {
+				*out++ = '<';
+				put_hex(out, *p++, 2);
+			} else if (mode == imm_extended) {
+				if (end - p < 2) goto truncated;
+				put_hex(out, (p[0] << 8) | p[1], 4);
+				p += 2;
+			} else if (!decode_indexed(p, end, code, pc, out)) {
+				goto truncated;
+			}
+			break;
+	}
+
+	*out = '\0';
+	return p - code;
+
+truncated:
+	operand[0] = '\0';
+	return 0;
+}
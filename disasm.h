@@ -0,0 +1,89 @@
+//
+//	disasm.h
+//
+
+#pragma once
+
+#include "typedefs.h"
+
+/*
+ * one disassembled instruction, formatted into fixed storage
+ */
+struct Disassembly {
+	Byte			length;		// bytes used, 0 if truncated
+	const char*		mnemonic;
+	char			operand[32];
+};
+
+/*
+ * a disassembler for the 6809 or 6309 instruction set, working
+ * only from the instruction's bytes and its address, without
+ * any CPU state and without allocating memory
+ */
+class Disassembler {
+
+public:
+	enum instruction_set { mc6809_set, hd6309_set };
+
+	// how an opcode's operand bytes are laid out and shown
+	enum mode : Byte {
+		illegal,
+		prefix,			// 0x10 and 0x11, leading the other pages
+		inherent,
+		imm8, imm16, imm32,
+		direct,
+		extended,
+		indexed,
+		rel8, rel16,
+		regpair,		// EXG, TFR and the 6309 register ops
+		reglist_s,		// PSHS and PULS
+		reglist_u,		// PSHU and PULU
+		tfm_pp, tfm_mm, tfm_pn, tfm_np,
+		bitop,			// 6309 BAND etc: postbyte then direct
+		imm_direct,		// 6309 OIM etc: immediate then address
+		imm_indexed,
+		imm_extended
+	};
+
+	// a decoded opcode
+	struct opcode {
+		const char*	mnemonic;
+		Byte		mode;
+	};
+
+protected:
+	// an indexed postbyte, formatted but for any offset after it
+	struct postbyte;
+
+	instruction_set		set;
+	const opcode*		table;		// pages 0x00, 0x10 and 0x11
+	const postbyte*		postbytes;
+	Byte			operand_bytes[3 * 256];	// as laid out in table
+
+	static const opcode*	table_6809();
+	static const opcode*	table_6309();
+	static const postbyte*	postbytes_6809();
+	static const postbyte*	postbytes_6309();
+
+	static void		block(opcode* t, Byte base, const char* const names[16], uint16_t wide, uint16_t none);
+	static void		inherent_row(opcode* t, Byte base, const char* const names[16]);
+	static void		fill_6809(opcode* t);
+	static void		fill_6309(opcode* t);
+	static void		fill_postbytes(postbyte* t, bool native);
+
+	bool			decode_indexed(const Byte*& p, const Byte* end, const Byte* code, Word pc, char*& out) const;
+	Byte			decode_operand(Byte mode, const Byte* code, const Byte* p, const Byte* end, Word pc, char* operand) const;
+
+public:
+	// decodes the instruction at `pc`, from at most `len` bytes
+	// of `code`, returning its length
+	Byte			decode(const Byte* code, size_t len, Word pc, Disassembly& insn) const;
+
+	// the opcode `ir`, including any 0x10 or 0x11 prefix
+	const opcode&		lookup(Word ir) const;
+
+// Public constructor
+public:
+				Disassembler(instruction_set set);
+
+};
@@ -15,8 +15,11 @@
 #include "dkc.h"
 #include "bits.h"
 
-dkc::dkc()
+dkc::dkc() : blockBuffer(BLOCK_SIZE)
 {
+    readIndex = 0;
+    sectorsLeft = 0;
+
     reset();
 
 	openDisk("disk1.img", 0);
@@ -64,10 +67,10 @@ Byte dkc::read(Word offset)
 	switch (offset) {
 		case CF_Data:
             {
-                if (readIndex < BLOCK_SIZE) {
+                if (readIndex < (int)blockBuffer.size()) {
                     val = blockBuffer[readIndex++];
-                    if (readIndex >= BLOCK_SIZE) {
-                        clearStatusBit(SR_DRQ);
+                    if (readIndex % BLOCK_SIZE == 0) {
+                        nextSector();
                     }
                 }
                 else {
@@ -176,6 +179,35 @@ void dkc::write(Word offset, Byte val)
 	}
 }
 
+void dkc::save(StateBuffer& state) const
+{
+    state.put(block_num);
+    state.put(blockBuffer.size());
+    state.put(blockBuffer.data(), blockBuffer.size());
+    state.put(readIndex);
+    state.put(sectorsLeft);
+    state.put(errorReg);
+    state.put(featureReg);
+    state.put(sectorCountReg);
+    state.put(statusReg);
+}
+
+void dkc::restore(StateReader& state)
+{
+    size_t size;
+
+    state.get(block_num);
+    state.get(size);
+    blockBuffer.resize(size);
+    state.get(blockBuffer.data(), size);
+    state.get(readIndex);
+    state.get(sectorsLeft);
+    state.get(errorReg);
+    state.get(featureReg);
+    state.get(sectorCountReg);
+    state.get(statusReg);
+}
+
 void dkc::reset(void)
 {
   	for (int i=0; i<MAX_DISKS; i++) {
@@ -223,6 +255,7 @@ void dkc::cfCommand(Byte cmd)
                 }
 
                 readIndex = 0;      // Reset the read buffer counter
+                sectorsLeft = 0;
     
                 // printf("CF: Execute 'Read Sectors' command (%02x)\r\n", cmd);
                 // printf("CF: Reading %d block%s from disk %d - block %d\r\n", 
@@ -237,20 +270,21 @@ void dkc::cfCommand(Byte cmd)
                     clearStatusBit(SR_BSY);
                 }
                 else {
-                    if (count != 1) {
-                        // printf("CF: Multi-block reads not supported\r\n");
+                    // All the sectors in one go, DRQ then staying
+                    // set until the last of them has been read
+                    size_t size = (size_t)count * BLOCK_SIZE;
+
+                    blockBuffer.resize(size);
+                    fseek(fd, (long)block*BLOCK_SIZE, SEEK_SET);
+                    if (fread(blockBuffer.data(), sizeof(char), size, fd) != size) {
+                        // printf("CF: failed to read blocks %d-%d\r\n", block, block+count-1);
+                        blockBuffer.resize(BLOCK_SIZE);
                         setStatusBit(SR_ERR);
                     }
                     else {
-                        fseek(fd, block*BLOCK_SIZE, SEEK_SET);
-                        if (fread(blockBuffer, sizeof(char), BLOCK_SIZE, fd) != BLOCK_SIZE) {
-                            // printf("CF: failed to read block %d\r\n", block);
-                            setStatusBit(SR_ERR);
-                        }
-                        else {
-                            // printf("CF: Read OK\r\n");
-                            setStatusBit(SR_DRQ);
-                        }
+                        // printf("CF: Read OK\r\n");
+                        sectorsLeft = count;
+                        setStatusBit(SR_DRQ);
                     }
                 }
                 clearStatusBit(SR_BSY);
@@ -289,11 +323,27 @@ void dkc::setFeatures()
     clearStatusBit(SR_BSY);
 }
 
-void dkc::clearBuffer()
+// A sector of a READ SECTORS has been drained, so move the
+// registers on as the real thing does, the LBA being left on the
+// last sector and the count at zero once they've all been read
+void dkc::nextSector()
 {
-    for (int i=0; i<BLOCK_SIZE; i++) {
-        blockBuffer[i] = 0;
+    if (sectorsLeft > 0) {
+        sectorCountReg--;
+        if (--sectorsLeft > 0) {
+            block_num = (block_num & 0xf0000000) | ((block_num + 1) & 0x0fffffff);
+            return;
+        }
     }
+
+    clearStatusBit(SR_DRQ);
+}
+
+void dkc::clearBuffer()
+{
+    blockBuffer.assign(BLOCK_SIZE, 0);
+    readIndex = 0;
+    sectorsLeft = 0;
 }
 
 void dkc::initDriveInfo(int drive)
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <vector>
 #include "device.h"
 #include "wiring.h"
 
@@ -53,8 +54,11 @@ class dkc : virtual public MappedDevice {
 		int32_t				block_num;
 		FILE				*disks[MAX_DISKS];
 		int					numBlocks[MAX_DISKS];
-        Byte                blockBuffer[BLOCK_SIZE];
+        // every sector a command reads, fetched at once and then
+        // drained through CF_Data a sector at a time
+        std::vector<Byte>   blockBuffer;
         int                 readIndex;
+        int                 sectorsLeft;    // still to be drained
 
         Byte                errorReg;
         Byte                featureReg;
@@ -69,6 +73,11 @@ class dkc : virtual public MappedDevice {
 		virtual Byte		read(Word offset);
 		virtual void		write(Word offset, Byte val);
 
+	// Snapshots, which don't include the disk images themselves
+	public:
+		virtual void		save(StateBuffer& state) const;
+		virtual void		restore(StateReader& state);
+
 	// Other exposed interfaces
 	public:
 
@@ -80,6 +89,7 @@ class dkc : virtual public MappedDevice {
         void reset(void);
         void cfCommand(Byte cmd);
         void setFeatures();
+        void nextSector();
         void clearBuffer();
         void initDriveInfo(int drive);
 
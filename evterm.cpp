@@ -0,0 +1,296 @@
+//
+//	evterm.cpp
+//
+
+#include <cerrno>
+#include <string>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "evterm.h"
+
+EventTerminal::EventTerminal(USim& sys) : Terminal(sys)
+{
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	wake_io = eventfd(0, EFD_CLOEXEC);
+	wake_cpu = eventfd(0, EFD_CLOEXEC);
+
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = wake_io;
+	(void)epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_io, &ev);
+
+	io = std::thread(&EventTerminal::run_io, this);
+}
+
+EventTerminal::~EventTerminal()
+{
+	stopping.store(true);
+	eventfd_write(wake_io, 1);
+	io.join();
+
+	if (inserting != -1) {
+		close(inserting);
+	}
+	close(wake_cpu);
+	close(wake_io);
+	close(epoll_fd);
+}
+
+// Wakes the other side if it's sleeping, or about to: the fence
+// pairs with the one in its sleep, so that either it sees what's
+// just been done to the ring, or this sees that it's sleeping
+void EventTerminal::notify(std::atomic<bool>& sleeping, int fd)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.exchange(false)) {
+		eventfd_write(fd, 1);
+	}
+}
+
+//------------------------------------------------------------------------
+// The I/O thread
+//------------------------------------------------------------------------
+
+// Returns the number of bytes read, or 0 at the end of the file
+size_t EventTerminal::read_into_rx(int fd, bool insert)
+{
+	Byte buf[256];
+	size_t n = std::min(rx.space(), sizeof buf);
+
+	ssize_t got = ::read(fd, buf, n);
+	if (got < 0 && errno == EINTR) {
+		return n;
+	}
+	if (got <= 0) {
+		return 0;
+	}
+
+	// an insert's bytes follow each other in the ring, as stdin
+	// isn't read in the meantime, and are marked before they're
+	// pushed so the guest never sees one that isn't marked yet
+	if (insert) {
+		uint64_t at = rx.pushed();
+		if (at != insert_end) {
+			insert_start = at;
+		}
+		insert_end = at + got;
+	}
+
+	for (ssize_t i = 0; i < got; ++i) {
+		rx.push(insert && buf[i] == '\n' ? '\r' : buf[i]);
+	}
+	notify(cpu_sleeping, wake_cpu);
+
+	return got;
+}
+
+void EventTerminal::flush_tx()
+{
+	Byte buf[256];
+	size_t n = 0;
+
+	while (!tx.empty() && n < sizeof buf) {
+		buf[n++] = tx.pop();
+	}
+	notify(cpu_sleeping, wake_cpu);
+
+	for (size_t done = 0; done < n; ) {
+		ssize_t put = ::write(fileno(output), buf + done, n - done);
+		if (put < 0 && errno != EINTR) {
+			break;
+		}
+		done += put > 0 ? put : 0;
+	}
+}
+
+void EventTerminal::run_io()
+{
+	// epoll won't take a regular file, so one redirected
+	// to stdin is read as if it were being inserted
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = input_fd;
+	bool pollable = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, input_fd, &ev) == 0;
+	bool polled = pollable;
+
+	for (;;) {
+		if (!tx.empty()) {
+			flush_tx();
+			continue;
+		}
+		if (stopping) {
+			break;
+		}
+
+		// files are read only as fast as the guest takes them
+		int insert = inserting;
+		if (insert != -1 && rx.space()) {
+			if (!read_into_rx(insert, true)) {
+				close(insert);
+				inserting = -1;
+			}
+			continue;
+		}
+		if (!pollable && input_open && rx.space()) {
+			if (!read_into_rx(input_fd, false)) {
+				input_open = false;
+				notify(cpu_sleeping, wake_cpu);
+			}
+			continue;
+		}
+
+		// stdin waits while the ring is full, or a file is inserted
+		bool want = pollable && input_open && insert == -1 && rx.space();
+		if (want != polled) {
+			(void)epoll_ctl(epoll_fd, want ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, input_fd, &ev);
+			polled = want;
+		}
+
+		io_sleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!tx.empty() || stopping || inserting != insert ||
+		    ((insert != -1 || (!pollable && input_open)) && rx.space()))
+		{
+			io_sleeping = false;
+			continue;
+		}
+
+		struct epoll_event events[2];
+		int n = epoll_wait(epoll_fd, events, 2, -1);
+		io_sleeping = false;
+
+		for (int i = 0; i < n; ++i) {
+			if (events[i].data.fd == wake_io) {
+				eventfd_t v;
+				eventfd_read(wake_io, &v);
+			} else if (!read_into_rx(input_fd, false)) {
+				(void)epoll_ctl(epoll_fd, EPOLL_CTL_DEL, input_fd, &ev);
+				polled = false;
+				input_open = false;
+				notify(cpu_sleeping, wake_cpu);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+// The CPU side
+//------------------------------------------------------------------------
+
+// Until the I/O thread has done something with the rings
+void EventTerminal::sleep_cpu()
+{
+	eventfd_t v;
+	eventfd_read(wake_cpu, &v);
+}
+
+bool EventTerminal::real_poll_read()
+{
+	return !rx.empty();
+}
+
+Byte EventTerminal::real_read()
+{
+	Byte b = rx.pop();
+	notify(io_sleeping, wake_io);
+	return b;
+}
+
+// Whether the guest's next byte came from an inserted file, which
+// may be still in the ring long after the file has been closed
+bool EventTerminal::injecting() const
+{
+	uint64_t next = rx.popped();
+	return next >= insert_start && next < insert_end;
+}
+
+// Sleep until there's input, unless there will never be any more
+void EventTerminal::wait_read()
+{
+	flush_output();
+
+	while (!read_data_available && rx.empty() && (input_open || inserting != -1)) {
+		cpu_sleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!rx.empty() || (!input_open && inserting == -1)) {
+			cpu_sleeping = false;
+			break;
+		}
+		sleep_cpu();
+	}
+}
+
+void EventTerminal::write(Byte ch)
+{
+	while (!tx.space()) {
+		flush_output();
+		cpu_sleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (tx.space()) {
+			cpu_sleeping = false;
+			break;
+		}
+		sleep_cpu();
+	}
+
+	tx.push(ch);
+	output_written(ch);
+}
+
+// Output is only handed over when Terminal decides it's time,
+// along with anything else printed to stdout in the meantime
+void EventTerminal::flush_output()
+{
+	fflush(output);
+	notify(io_sleeping, wake_io);
+	unflushed = false;
+}
+
+// As Terminal's, but the file name has to come through the ring
+// like any other input, being typed in raw mode
+bool EventTerminal::open_insert_file()
+{
+	std::string filename;
+
+	if (inserting != -1) {
+		return false;
+	}
+
+	fprintf(stderr, "File: ");
+	for (;;) {
+		wait_read();
+		if (rx.empty()) {
+			return false;			// stdin has closed
+		}
+
+		Byte ch = real_read();
+		if (ch == '\r' || ch == '\n') {
+			break;
+		}
+		if (ch == 0x7f || ch == '\b') {
+			if (!filename.empty()) {
+				filename.pop_back();
+				fprintf(stderr, "\b \b");
+			}
+			continue;
+		}
+		filename.push_back(ch);
+		fputc(ch, stderr);
+	}
+	fprintf(stderr, "\r\n");
+
+	FILE* fp = fopen(filename.c_str(), "r");
+	if (!fp) {
+		return false;
+	}
+
+	// the I/O thread owns it from here
+	inserting = dup(fileno(fp));
+	fclose(fp);
+	notify(io_sleeping, wake_io);
+
+	return true;
+}
@@ -0,0 +1,111 @@
+//
+//	evterm.h
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "term.h"
+
+/*
+ * a lock-free ring of bytes between one producer and one consumer
+ * thread, each of which only ever moves its own end
+ */
+class ByteRing {
+
+protected:
+	std::vector<Byte>		ring;
+	size_t				mask;
+
+	std::atomic<uint64_t>	head{0};	// next byte to be written
+	std::atomic<uint64_t>	tail{0};	// next to be read
+
+public:
+	bool				empty() const {
+						return head.load(std::memory_order_acquire) ==
+							tail.load(std::memory_order_relaxed);
+					}
+
+	size_t				space() const {
+						return ring.size() - (head.load(std::memory_order_relaxed) -
+							tail.load(std::memory_order_acquire));
+					}
+
+	// how many bytes have ever been written and read, which
+	// only the producer and consumer respectively may ask
+	uint64_t			pushed() const { return head.load(std::memory_order_relaxed); }
+	uint64_t			popped() const { return tail.load(std::memory_order_relaxed); }
+
+	// only when !empty() and space() respectively
+	Byte				pop() {
+						uint64_t t = tail.load(std::memory_order_relaxed);
+						Byte b = ring[t & mask];
+						tail.store(t + 1, std::memory_order_release);
+						return b;
+					}
+
+	void				push(Byte b) {
+						uint64_t h = head.load(std::memory_order_relaxed);
+						ring[h & mask] = b;
+						head.store(h + 1, std::memory_order_release);
+					}
+
+// Public constructor, `size` being a power of two
+public:
+					ByteRing(size_t size) : ring(size), mask(size - 1) {};
+
+};
+
+/*
+ * a Terminal whose host I/O is all done by a thread of its own,
+ * waiting in epoll on stdin, so that the CPU only ever touches
+ * the rings between them and makes no system calls of its own
+ * unless it has to wait for input, or for room for its output
+ *
+ * an inserted file, or a stdin redirected from one, can't be waited
+ * on, so is read straight into the ring as fast as it's emptied
+ */
+class EventTerminal : public Terminal {
+
+protected:
+	ByteRing			rx{4096};	// to the guest
+	ByteRing			tx{4096};	// from the guest
+
+	int				epoll_fd;
+	int				wake_io;	// eventfds, each written
+	int				wake_cpu;	// only while that side sleeps
+
+	std::atomic<bool>		io_sleeping{false};
+	std::atomic<bool>		cpu_sleeping{false};
+	std::atomic<bool>		stopping{false};
+	std::atomic<bool>		input_open{true};
+	std::atomic<int>		inserting{-1};
+	std::atomic<uint64_t>		insert_start{0};	// where in rx the inserted
+	std::atomic<uint64_t>		insert_end{0};		// bytes are, as pushed()
+
+	std::thread			io;
+
+	void				run_io();
+	size_t				read_into_rx(int fd, bool insert);
+	void				flush_tx();
+	void				notify(std::atomic<bool>& sleeping, int fd);
+	void				sleep_cpu();
+
+	virtual bool			real_poll_read();
+	virtual Byte			real_read();
+	virtual bool			open_insert_file();
+	virtual void			flush_output();
+	virtual bool			injecting() const;
+
+public:
+	virtual void			wait_read();
+	virtual void			write(Byte);
+
+// Public constructor and destructor
+public:
+					EventTerminal(USim& sys);
+	virtual				~EventTerminal();
+
+};
@@ -6,10 +6,12 @@
 //
 
 #include "hd6309.h"
+#include "trace.h"
 #include <memory>
+#include <vector>
 #include <cstdio>
 
-hd6309::hd6309() : a(acc.byte.a), b(acc.byte.b), e(acc.byte.e), f(acc.byte.f), d(acc.word.d), w(acc.word.w), q(acc.q)
+hd6309::hd6309() : a(acc.byte.a), b(acc.byte.b), e(acc.byte.e), f(acc.byte.f), d(acc.word.d), w(acc.word.w), q(acc.q), opcodes(opcode_table()), disasm(Disassembler::hd6309_set)
 {
 }
 
@@ -19,6 +21,7 @@ hd6309::~hd6309()
 
 void hd6309::reset()
 {
+	eval_cc();
 	USim::reset();
 
 	pc = read_word(0xfffe);
@@ -38,15 +41,105 @@ void hd6309::reset()
     md.bit.fm = 0;          /* 6809 FIRQ mode */
 }
 
+void hd6309::save_state(StateBuffer& state)
+{
+	USim::save_state(state);
+
+	eval_cc();
+	state.put(cc.all);
+	state.put(dp);
+	state.put(q);
+	state.put(md.all);
+	state.put(x);
+	state.put(y);
+	state.put(u);
+	state.put(s);
+	state.put(waiting_sync);
+	state.put(waiting_cwai);
+	state.put(nmi_previous);
+}
+
+void hd6309::restore_state(StateReader& state)
+{
+	USim::restore_state(state);
+
+	state.get(cc.all);
+	state.get(dp);
+	state.get(q);
+	state.get(md.all);
+	state.get(x);
+	state.get(y);
+	state.get(u);
+	state.get(s);
+	state.get(waiting_sync);
+	state.get(waiting_cwai);
+	state.get(nmi_previous);
+
+	lazy = {};
+	idle_loop_instructions = 0;
+}
+
 void hd6309::tick()
 {
 	// handle the attached devices
 	USim::tick();
 
+	// run one instruction, or wait for an interrupt
+	step();
+
+	// then advance the clock, allowing one cycle for a wait
+	clock.now += cycles ? cycles : 1;
+	cycles = 0;
+}
+
+// What tick() does, until done() says to stop, but calling step()
+// directly rather than through the virtual tick() USim's loops use
+template<typename Done>
+inline Cycles hd6309::run_while_not(Done done)
+{
+	Cycles start = clock.now;
+
+	halted = false;
+	while (!halted && !done()) {
+		if (clock.now >= clock.next_event) {
+			tick_devices();
+		}
+		step();
+		clock.now += cycles ? cycles : 1;
+		cycles = 0;
+	}
+	return clock.now - start;
+}
+
+void hd6309::run()
+{
+	run_while_not([]() { return false; });
+}
+
+Cycles hd6309::run_for(Cycles n)
+{
+	run_limit = clock.now + n;
+	Cycles used = run_while_not([this]() { return clock.now >= run_limit; });
+	run_limit = UINT64_MAX;
+	return used;
+}
+
+Cycles hd6309::run_until(Word addr)
+{
+	return run_while_not([this, addr]() { return pc == addr; });
+}
+
+Cycles hd6309::run_until(const std::function<bool()>& done)
+{
+	return run_while_not(done);
+}
+
+void hd6309::step()
+{
 	// get interrupt pin states
-	bool c_nmi = NMI;
-	bool c_firq = FIRQ;
-	bool c_irq = IRQ;
+	bool c_nmi = NMI_line && NMI;
+	bool c_firq = FIRQ_line && FIRQ;
+	bool c_irq = IRQ_line && IRQ;
 
 	// check for NMI falling edge
 	bool nmi_triggered = !c_nmi && nmi_previous;
@@ -57,6 +150,7 @@ void hd6309::tick()
 		if (nmi_triggered || !c_firq || !c_irq) {
 			waiting_sync = false;
 		} else {
+			skip_idle(1);
 			return;
 		}
 	}
@@ -69,6 +163,7 @@ void hd6309::tick()
 	} else if (!c_irq && !cc.bit.i) {
 		do_irq();
 	} else if (waiting_cwai) {
+		skip_idle(1);
 		return;
 	}
 
@@ -77,21 +172,29 @@ void hd6309::tick()
 
 	// remember current instruction address
 	insn_pc = pc;
+	++instructions;
 
 	// hook
 	pre_exec();
 
-	// fetch the next instruction
-	fetch_instruction();
+	if (predecoded.empty()) {
+		// fetch the next instruction
+		fetch_instruction();
 
-	// and process it
-	execute_instruction();
+		// and process it
+		execute_instruction();
+	} else {
+		execute_predecoded();
+	}
 
 	// hook
 	post_exec();
 
-	// deduct a cycle to account for the one added in USim::tick
-	--cycles;
+#ifdef PROFILE
+	if (profiler) {
+		profiler->add(insn_pc, cycles);
+	}
+#endif
 }
 
 void hd6309::do_nmi()
@@ -102,6 +205,7 @@ void hd6309::do_nmi()
 	}
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfffc);
+	profile_call(s);
 }
 
 void hd6309::do_firq()
@@ -112,6 +216,7 @@ void hd6309::do_firq()
 	}
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfff6);
+	profile_call(s);
 }
 
 void hd6309::do_irq()
@@ -122,450 +227,607 @@ void hd6309::do_irq()
 	}
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfff8);
+	profile_call(s);
 }
 
 void hd6309::fetch_instruction()
 {
+	const opcode* page = opcodes;
+
 	ir = fetch();
 
 	// look for two-byte instructions
 	if (ir == 0x10 || ir == 0x11) {
+		page += (ir - 0x0f) * 256;
 		ir <<= 8;
 		ir |= fetch();
 	}
 
-	// Decode addressing mode
+	op = &page[ir & 0xff];
+	mode = op->mode;
+	insn = op->mnemonic;
+}
+
+void hd6309::execute_instruction()
+{
+	(this->*op->handler)();
+}
+
+//---------------------------------------------------------------------
+//
+// predecoded instruction cache
+//
+//---------------------------------------------------------------------
+
+void hd6309::predecode_on()
+{
+	predecoded.assign(0x10000, {});
+}
+
+void hd6309::predecode_off()
+{
+	predecoded.clear();
+	predecoded.shrink_to_fit();
+}
+
+// Runs the instruction at PC from the cache if its page has not been
+// written since it was decoded, otherwise decodes and executes it in
+// the usual way, recording the decode for next time
+void hd6309::execute_predecoded()
+{
+	decoded& d = predecoded[pc];
+	Byte page = pc >> 8;
+
+	if (d.op && d.gen == page_gen[page]) {
+		replaying = &d;
+		ir = d.ir;
+		op = d.op;
+		mode = op->mode;
+		insn = op->mnemonic;
+		pc += d.length;
+		cycles += d.opcode_length;
+		execute_instruction();
+		replaying = nullptr;
+		return;
+	}
+
+	uint32_t gen = page_gen[page];
+
+	d.op = nullptr;
+	recording = &d;
+	fetch_instruction();
+	d.opcode_length = d.length = pc - insn_pc;
+	execute_instruction();
+	recording = nullptr;
+
+	// only instructions held entirely within one page of
+	// plain memory can be revalidated by the page generation
+	if (pages[page].read && ((insn_pc + d.length - 1) >> 8) == page) {
+		d.op = op;
+		d.ir = ir;
+		d.gen = gen;
+	}
+}
+
+//---------------------------------------------------------------------
+//
+// opcode dispatch table
+//
+//---------------------------------------------------------------------
+
+// Addressing mode implied by an opcode, used to build the table
+hd6309::addressing_mode hd6309::decode_mode(Word ir)
+{
 	switch (ir & 0xf0) {
 		case 0x00: case 0x90: case 0xd0:
-			mode = direct; break;
+			return direct;
 		case 0x20:
-			mode = relative; break;
+			return relative;
 		case 0x30: case 0x40: case 0x50:
 			if (ir < 0x34) {
-				mode = indexed;
+				return indexed;
 			} else if (ir < 0x38 || ir == 0x3c) {
-				mode = immediate;
+				return immediate;
 			} else {
-				mode = inherent;
+				return inherent;
 			}
-			break;
 		case 0x60: case 0xa0: case 0xe0:
-			mode = indexed; break;
+			return indexed;
 		case 0x70: case 0xb0: case 0xf0:
-			mode = extended; break;
+			return extended;
 		case 0x80: case 0xc0:
 			if (ir == 0x8d) {
-				mode = relative;
+				return relative;
 			} else {
-				mode = immediate;
+				return immediate;
 			}
-			break;
 		case 0x10:
 			switch (ir & 0x0f) {
 				case 0x02: case 0x03: case 0x09: case 0x0d:
-					mode = inherent; break;
+					return inherent;
 				case 0x06: case 0x07:
-					mode = relative; break;
+					return relative;
 				case 0x0a: case 0x0c: case 0x0e: case 0x0f:
-					mode = immediate; break;
+					return immediate;
 			}
-			break;
 	}
+
+	return inherent;
 }
 
-void hd6309::execute_instruction()
+// One entry for each opcode in pages 0x00, 0x10 and 0x11.  Opcodes
+// not listed here are treated as NOP
+const hd6309::opcode* hd6309::opcode_table()
 {
-	switch (ir) {
-		case 0x3a:
-			abx(); break;
-		case 0x89: case 0x99: case 0xa9: case 0xb9:
-			adca(); break;
-		case 0xc9: case 0xd9: case 0xe9: case 0xf9:
-			adcb(); break;
-		case 0x8b: case 0x9b: case 0xab: case 0xbb:
-			adda(); break;
-		case 0xcb: case 0xdb: case 0xeb: case 0xfb:
-			addb(); break;
-		case 0x118b: case 0x119b: case 0x11ab: case 0x11bb:
-			adde(); break;
-		case 0x11cb: case 0x11db: case 0x11eb: case 0x11fb:
-			addf(); break;
-		case 0xc3: case 0xd3: case 0xe3: case 0xf3:
-			addd(); break;
-		case 0x108b: case 0x109b: case 0x10ab: case 0x10bb:
-			addw(); break;
-		case 0x84: case 0x94: case 0xa4: case 0xb4:
-			anda(); break;
-		case 0xc4: case 0xd4: case 0xe4: case 0xf4:
-			andb(); break;
-        case 0x1084: case 0x1094: case 0x10a4: case 0x10b4:
-            andd(); break;
-		case 0x1c:
-			andcc(); break;
-		case 0x47:
-			asra(); break;
-		case 0x57:
-			asrb(); break;
-		case 0x07: case 0x67: case 0x77:
-			asr(); break;
-		case 0x24:
-			bcc(); break;
-		case 0x25:
-			bcs(); break;
-		case 0x27:
-			beq(); break;
-		case 0x2c:
-			bge(); break;
-		case 0x2e:
-			bgt(); break;
-		case 0x22:
-			bhi(); break;
-		case 0x85: case 0x95: case 0xa5: case 0xb5:
-			bita(); break;
-		case 0xc5: case 0xd5: case 0xe5: case 0xf5:
-			bitb(); break;
-        case 0x1085: case 0x1095: case 0x10a5: case 0x10b5:
-            bitd(); break;
-        case 0x113c:
-            bitmd(); break;
-		case 0x2f:
-			ble(); break;
-		case 0x23:
-			bls(); break;
-		case 0x2d:
-			blt(); break;
-		case 0x2b:
-			bmi(); break;
-		case 0x26:
-			bne(); break;
-		case 0x2a:
-			bpl(); break;
-		case 0x20:
-			bra(); break;
-		case 0x16:
-			lbra(); break;
-		case 0x21:
-			brn(); break;
-		case 0x8d:
-			bsr(); break;
-		case 0x17:
-			lbsr(); break;
-		case 0x28:
-			bvc(); break;
-		case 0x29:
-			bvs(); break;
-		case 0x4e: case 0x4f:
-			// 0x4e undocumented
-			clra(); break;
-		case 0x5e: case 0x5f:
-			// 0x5e undocumented
-			clrb(); break;
-        case 0x114f:
-            clre(); break;
-        case 0x115f:
-            clrf(); break;
-        case 0x104f:
-            clrd(); break;
-        case 0x105f:
-            clrw(); break;
-		case 0x0f: case 0x6f: case 0x7f:
-			clr(); break;
-		case 0x81: case 0x91: case 0xa1: case 0xb1:
-			cmpa(); break;
-		case 0xc1: case 0xd1: case 0xe1: case 0xf1:
-			cmpb(); break;
-		case 0x1181: case 0x1191: case 0x11a1: case 0x11b1:
-			cmpe(); break;
-		case 0x11c1: case 0x11d1: case 0x11e1: case 0x11f1:
-			cmpf(); break;
-		case 0x1083: case 0x1093: case 0x10a3: case 0x10b3:
-			cmpd(); break;
-		case 0x1081: case 0x1091: case 0x10a1: case 0x10b1:
-			cmpw(); break;
-		case 0x118c: case 0x119c: case 0x11ac: case 0x11bc:
-			cmps(); break;
-		case 0x8c: case 0x9c: case 0xac: case 0xbc:
-			cmpx(); break;
-		case 0x1183: case 0x1193: case 0x11a3: case 0x11b3:
-			cmpu(); break;
-		case 0x108c: case 0x109c: case 0x10ac: case 0x10bc:
-			cmpy(); break;
-		case 0x42: case 0x43: case 0x1042:
-			// 0x42 / 0x1042 undocumented
-			coma(); break;
-		case 0x52: case 0x53:
-			// 0x52 undocumented
-			comb(); break;
-        case 0x1143:
-            come(); break;
-        case 0x1153:
-            comf(); break;
-        case 0x1043:
-            comd(); break;
-        case 0x1053:
-            comw(); break;
-		case 0x03: case 0x62: case 0x63: case 0x73:
-			// 0x62 undocumented
-			com(); break;
-		case 0x3c:
-			cwai(); break;
-		case 0x19:
-			daa(); break;
-		case 0x4a: case 0x4b:
-			// 0x4b undocumented
-			deca(); break;
-		case 0x5a: case 0x5b:
-			// 0x5b undocumented
-			decb(); break;
-		case 0x114a:
-			dece(); break;
-		case 0x115a:
-			decf(); break;
-		case 0x104a:
-			decd(); break;
-		case 0x105a:
-			decw(); break;
-		case 0x0a: case 0x0b:
-		case 0x6a: case 0x6b:
-		case 0x7a: case 0x7b:
-			// 0x0b, 0x6b, 0x7b undocumented
-			dec(); break;
-		case 0x88: case 0x98: case 0xa8: case 0xb8:
-			eora(); break;
-		case 0xc8: case 0xd8: case 0xe8: case 0xf8:
-			eorb(); break;
-        case 0x1088: case 0x1098: case 0x10a8: case 0x10b8:
-            eord(); break;
-		case 0x1e:
-			exg(); break;
-		case 0x4c:
-			inca(); break;
-		case 0x5c:
-			incb(); break;
-		case 0x114c:
-			ince(); break;
-		case 0x115c:
-			incf(); break;
-		case 0x104c:
-			incd(); break;
-		case 0x105c:
-			incw(); break;
-		case 0x0c: case 0x6c: case 0x7c:
-			inc(); break;
-		case 0x0e: case 0x6e: case 0x7e:
-			jmp(); break;
-		case 0x9d: case 0xad: case 0xbd:
-			jsr(); break;
-		case 0x86: case 0x96: case 0xa6: case 0xb6:
-			lda(); break;
-		case 0xc6: case 0xd6: case 0xe6: case 0xf6:
-			ldb(); break;
-		case 0x1186: case 0x1196: case 0x11a6: case 0x11b6:
-			lde(); break;
-		case 0x11c6: case 0x11d6: case 0x11e6: case 0x11f6:
-			ldf(); break;
-		case 0xcc: case 0xdc: case 0xec: case 0xfc:
-			ldd(); break;
-		case 0x1086: case 0x1096: case 0x10a6: case 0x10b6:
-			ldw(); break;
-		case 0x10ce: case 0x10de: case 0x10ee: case 0x10fe:
-			lds(); break;
-		case 0xce: case 0xde: case 0xee: case 0xfe:
-			ldu(); break;
-		case 0x8e: case 0x9e: case 0xae: case 0xbe:
-			ldx(); break;
-		case 0x108e: case 0x109e: case 0x10ae: case 0x10be:
-			ldy(); break;
-        case 0x113d:
-            ldmd(); break;
-		case 0x32:
-			leas(); break;
-		case 0x33:
-			leau(); break;
-		case 0x30:
-			leax(); break;
-		case 0x31:
-			leay(); break;
-		case 0x48:
-			lsla(); break;
-		case 0x58:
-			lslb(); break;
-        case 0x1048:
-            lsld(); break;
-		case 0x08: case 0x68: case 0x78:
-			lsl(); break;
-		case 0x44: case 0x45:
-			// 0x45 undocumented
-			lsra(); break;
-		case 0x54: case 0x55:
-			// 0x55 undocumented
-			lsrb(); break;
-        case 0x1044:
-            lsrd(); break;
-        case 0x1054:
-            lsrw(); break;
-		case 0x04: case 0x05:
-		case 0x64: case 0x65:
-		case 0x74: case 0x75:
-			// 0x05, 0x65, 0x75 undocumented
-			lsr(); break;
-		case 0x3d:
-			mul(); break;
-		case 0x40: case 0x41:
-			// 0x41 undocumented
-			nega(); break;
-		case 0x50: case 0x51:
-			// 0x51 undocumented
-			negb(); break;
-		case 0x00: case 0x01:
-		case 0x60: case 0x61:
-		case 0x70: case 0x71:
-			// 0x01, 0x61, 0x71 undocumented
-			neg(); break;
-		case 0x12:
-			nop(); break;
-		case 0x8a: case 0x9a: case 0xaa: case 0xba:
-			ora(); break;
-		case 0xca: case 0xda: case 0xea: case 0xfa:
-			orb(); break;
-        case 0x108a: case 0x109a: case 0x10aa: case 0x10ba:
-            ord(); break;
-		case 0x1a:
-			orcc(); break;
-		case 0x34:
-			pshs(); break;
-		case 0x36:
-			pshu(); break;
-		case 0x35:
-			puls(); break;
-		case 0x37:
-			pulu(); break;
-		case 0x49:
-			rola(); break;	
-		case 0x59:
-			rolb(); break;
-        case 0x1049:
-            rold(); break;
-        case 0x1059:
-            rolw(); break;
-		case 0x09: case 0x69: case 0x79:
-			rol(); break;
-		case 0x46:
-			rora(); break;	
-		case 0x56:
-			rorb(); break;
-        case 0x1046:
-            rord(); break;
-        case 0x1056:
-            rorw(); break;
-		case 0x06: case 0x66: case 0x76:
-			ror(); break;
-		case 0x3b:
-			rti(); break;
-		case 0x39:
-			rts(); break;
-		case 0x82: case 0x92: case 0xa2: case 0xb2: 
-			sbca(); break;
-		case 0xc2: case 0xd2: case 0xe2: case 0xf2: 
-			sbcb(); break;
-        case 0x1082: case 0x1092: case 0x10a2: case 0x10b2:
-            sbcd(); break;
-		case 0x1d:
-			sex(); break;
-		case 0x97: case 0xa7: case 0xb7:
-			sta(); break;
-		case 0xd7: case 0xe7: case 0xf7:
-			stb(); break;
-		case 0x1197: case 0x11a7: case 0x11b7:
-			ste(); break;
-		case 0x11d7: case 0x11e7: case 0x11f7:
-			stf(); break;
-		case 0xdd: case 0xed: case 0xfd:
-			std(); break;
-		case 0x1097: case 0x10a7: case 0x10b7:
-			stw(); break;
-		case 0x10df: case 0x10ef: case 0x10ff:
-			sts(); break;
-		case 0xdf: case 0xef: case 0xff:
-			stu(); break;
-		case 0x9f: case 0xaf: case 0xbf:
-			stx(); break;
-		case 0x109f: case 0x10af: case 0x10bf:
-			sty(); break;
-		case 0x80: case 0x90: case 0xa0: case 0xb0:
-			suba(); break;
-		case 0xc0: case 0xd0: case 0xe0: case 0xf0:
-			subb(); break;
-		case 0x1180: case 0x1190: case 0x11a0: case 0x11b0:
-			sube(); break;
-		case 0x11c0: case 0x11d0: case 0x11e0: case 0x11f0:
-			subf(); break;
-		case 0x83: case 0x93: case 0xa3: case 0xb3:
-			subd(); break;
-		case 0x1080: case 0x1090: case 0x10a0: case 0x10b0:
-			subw(); break;
-		case 0x3f:
-			swi(); break;
-		case 0x103f:
-			swi2(); break;
-		case 0x113f:
-			swi3(); break;
-		case 0x13:
-			sync(); break;
-		case 0x1f:
-			tfr(); break;
-		case 0x4d:
-			tsta(); break;
-		case 0x5d:
-			tstb(); break;
-		case 0x114d:
-			tste(); break;
-		case 0x115d:
-			tstf(); break;
-		case 0x104d:
-			tstd(); break;
-		case 0x105d:
-			tstw(); break;
-		case 0x0d: case 0x6d: case 0x7d:
-			tst(); break;
-		case 0x1024:
-			lbcc(); break;
-		case 0x1025:
-			lbcs(); break;
-		case 0x1027:
-			lbeq(); break;
-		case 0x102c:
-			lbge(); break;
-		case 0x102e:
-			lbgt(); break;
-		case 0x1022:
-			lbhi(); break;
-		case 0x102f:
-			lble(); break;
-		case 0x1023:
-			lbls(); break;
-		case 0x102d:
-			lblt(); break;
-		case 0x102b:
-			lbmi(); break;
-		case 0x1026:
-			lbne(); break;
-		case 0x102a:
-			lbpl(); break;
-		case 0x1021:
-			lbrn(); break;
-		case 0x1028:
-			lbvc(); break;
-		case 0x1029:
-			lbvs(); break;
-		default:
-            nop();  // Treat invalid instruction as NOP
-			// invalid("invalid instruction");
+	static const struct {
+		Word		ir;
+		void		(hd6309::*handler)();
+		const char*	mnemonic;
+	} defs[] = {
+		{ 0x00,	&hd6309::neg,			"NEG" },
+		{ 0x01,	&hd6309::neg,			"NEG" },	// undocumented
+		{ 0x03,	&hd6309::com,			"COM" },
+		{ 0x04,	&hd6309::lsr,			"LSR" },
+		{ 0x05,	&hd6309::lsr,			"LSR" },	// undocumented
+		{ 0x06,	&hd6309::ror,			"ROR" },
+		{ 0x07,	&hd6309::asr,			"ASR" },
+		{ 0x08,	&hd6309::lsl,			"LSL" },
+		{ 0x09,	&hd6309::rol,			"ROL" },
+		{ 0x0a,	&hd6309::dec,			"DEC" },
+		{ 0x0b,	&hd6309::dec,			"DEC" },	// undocumented
+		{ 0x0c,	&hd6309::inc,			"INC" },
+		{ 0x0d,	&hd6309::tst,			"TST" },
+		{ 0x0e,	&hd6309::jmp,			"JMP" },
+		{ 0x0f,	&hd6309::clr,			"CLR" },
+		{ 0x12,	&hd6309::nop,			"NOP" },
+		{ 0x13,	&hd6309::sync,			"SYNC" },
+		{ 0x16,	&hd6309::lbra,			"LBRA" },
+		{ 0x17,	&hd6309::lbsr,			"LBSR" },
+		{ 0x19,	&hd6309::daa,			"DAA" },
+		{ 0x1a,	&hd6309::orcc,			"ORCC" },
+		{ 0x1c,	&hd6309::andcc,			"ANDCC" },
+		{ 0x1d,	&hd6309::sex,			"SEX" },
+		{ 0x1e,	&hd6309::exg,			"EXG" },
+		{ 0x1f,	&hd6309::tfr,			"TFR" },
+		{ 0x20,	&hd6309::bra,			"BRA" },
+		{ 0x21,	&hd6309::brn,			"BRN" },
+		{ 0x22,	&hd6309::bhi,			"BHI" },
+		{ 0x23,	&hd6309::bls,			"BLS" },
+		{ 0x24,	&hd6309::bcc,			"BCC" },
+		{ 0x25,	&hd6309::bcs,			"BCS" },
+		{ 0x26,	&hd6309::bne,			"BNE" },
+		{ 0x27,	&hd6309::beq,			"BEQ" },
+		{ 0x28,	&hd6309::bvc,			"BVC" },
+		{ 0x29,	&hd6309::bvs,			"BVS" },
+		{ 0x2a,	&hd6309::bpl,			"BPL" },
+		{ 0x2b,	&hd6309::bmi,			"BMI" },
+		{ 0x2c,	&hd6309::bge,			"BGE" },
+		{ 0x2d,	&hd6309::blt,			"BLT" },
+		{ 0x2e,	&hd6309::bgt,			"BGT" },
+		{ 0x2f,	&hd6309::ble,			"BLE" },
+		{ 0x30,	&hd6309::leax,			"LEAX" },
+		{ 0x31,	&hd6309::leay,			"LEAY" },
+		{ 0x32,	&hd6309::leas,			"LEAS" },
+		{ 0x33,	&hd6309::leau,			"LEAU" },
+		{ 0x34,	&hd6309::pshs,			"PSHS" },
+		{ 0x35,	&hd6309::puls,			"PULS" },
+		{ 0x36,	&hd6309::pshu,			"PSHU" },
+		{ 0x37,	&hd6309::pulu,			"PULU" },
+		{ 0x39,	&hd6309::rts,			"RTS" },
+		{ 0x3a,	&hd6309::abx,			"ABX" },
+		{ 0x3b,	&hd6309::rti,			"RTI" },
+		{ 0x3c,	&hd6309::cwai,			"CWAI" },
+		{ 0x3d,	&hd6309::mul,			"MUL" },
+		{ 0x3f,	&hd6309::swi,			"SWI" },
+		{ 0x40,	&hd6309::nega,			"NEGA" },
+		{ 0x41,	&hd6309::nega,			"NEGA" },	// undocumented
+		{ 0x42,	&hd6309::coma,			"COMA" },	// undocumented
+		{ 0x43,	&hd6309::coma,			"COMA" },
+		{ 0x44,	&hd6309::lsra,			"LSRA" },
+		{ 0x45,	&hd6309::lsra,			"LSRA" },	// undocumented
+		{ 0x46,	&hd6309::rora,			"RORA" },
+		{ 0x47,	&hd6309::asra,			"ASRA" },
+		{ 0x48,	&hd6309::lsla,			"LSLA" },
+		{ 0x49,	&hd6309::rola,			"ROLA" },
+		{ 0x4a,	&hd6309::deca,			"DECA" },
+		{ 0x4b,	&hd6309::deca,			"DECA" },	// undocumented
+		{ 0x4c,	&hd6309::inca,			"INCA" },
+		{ 0x4d,	&hd6309::tsta,			"TSTA" },
+		{ 0x4e,	&hd6309::clra,			"CLRA" },	// undocumented
+		{ 0x4f,	&hd6309::clra,			"CLRA" },
+		{ 0x50,	&hd6309::negb,			"NEGB" },
+		{ 0x51,	&hd6309::negb,			"NEGB" },	// undocumented
+		{ 0x52,	&hd6309::comb,			"COMB" },	// undocumented
+		{ 0x53,	&hd6309::comb,			"COMB" },
+		{ 0x54,	&hd6309::lsrb,			"LSRB" },
+		{ 0x55,	&hd6309::lsrb,			"LSRB" },	// undocumented
+		{ 0x56,	&hd6309::rorb,			"RORB" },
+		{ 0x57,	&hd6309::asrb,			"ASRB" },
+		{ 0x58,	&hd6309::lslb,			"LSLB" },
+		{ 0x59,	&hd6309::rolb,			"ROLB" },
+		{ 0x5a,	&hd6309::decb,			"DECB" },
+		{ 0x5b,	&hd6309::decb,			"DECB" },	// undocumented
+		{ 0x5c,	&hd6309::incb,			"INCB" },
+		{ 0x5d,	&hd6309::tstb,			"TSTB" },
+		{ 0x5e,	&hd6309::clrb,			"CLRB" },	// undocumented
+		{ 0x5f,	&hd6309::clrb,			"CLRB" },
+		{ 0x60,	&hd6309::neg,			"NEG" },
+		{ 0x61,	&hd6309::neg,			"NEG" },	// undocumented
+		{ 0x62,	&hd6309::com,			"COM" },	// undocumented
+		{ 0x63,	&hd6309::com,			"COM" },
+		{ 0x64,	&hd6309::lsr,			"LSR" },
+		{ 0x65,	&hd6309::lsr,			"LSR" },	// undocumented
+		{ 0x66,	&hd6309::ror,			"ROR" },
+		{ 0x67,	&hd6309::asr,			"ASR" },
+		{ 0x68,	&hd6309::lsl,			"LSL" },
+		{ 0x69,	&hd6309::rol,			"ROL" },
+		{ 0x6a,	&hd6309::dec,			"DEC" },
+		{ 0x6b,	&hd6309::dec,			"DEC" },	// undocumented
+		{ 0x6c,	&hd6309::inc,			"INC" },
+		{ 0x6d,	&hd6309::tst,			"TST" },
+		{ 0x6e,	&hd6309::jmp,			"JMP" },
+		{ 0x6f,	&hd6309::clr,			"CLR" },
+		{ 0x70,	&hd6309::neg,			"NEG" },
+		{ 0x71,	&hd6309::neg,			"NEG" },	// undocumented
+		{ 0x73,	&hd6309::com,			"COM" },
+		{ 0x74,	&hd6309::lsr,			"LSR" },
+		{ 0x75,	&hd6309::lsr,			"LSR" },	// undocumented
+		{ 0x76,	&hd6309::ror,			"ROR" },
+		{ 0x77,	&hd6309::asr,			"ASR" },
+		{ 0x78,	&hd6309::lsl,			"LSL" },
+		{ 0x79,	&hd6309::rol,			"ROL" },
+		{ 0x7a,	&hd6309::dec,			"DEC" },
+		{ 0x7b,	&hd6309::dec,			"DEC" },	// undocumented
+		{ 0x7c,	&hd6309::inc,			"INC" },
+		{ 0x7d,	&hd6309::tst,			"TST" },
+		{ 0x7e,	&hd6309::jmp,			"JMP" },
+		{ 0x7f,	&hd6309::clr,			"CLR" },
+		{ 0x80,	&hd6309::suba,			"SUBA" },
+		{ 0x81,	&hd6309::cmpa,			"CMPA" },
+		{ 0x82,	&hd6309::sbca,			"SBCA" },
+		{ 0x83,	&hd6309::subd,			"SUBD" },
+		{ 0x84,	&hd6309::anda,			"ANDA" },
+		{ 0x85,	&hd6309::bita,			"BITA" },
+		{ 0x86,	&hd6309::lda,			"LDA" },
+		{ 0x88,	&hd6309::eora,			"EORA" },
+		{ 0x89,	&hd6309::adca,			"ADCA" },
+		{ 0x8a,	&hd6309::ora,			"ORA" },
+		{ 0x8b,	&hd6309::adda,			"ADDA" },
+		{ 0x8c,	&hd6309::cmpx,			"CMPX" },
+		{ 0x8d,	&hd6309::bsr,			"BSR" },
+		{ 0x8e,	&hd6309::ldx,			"LDX" },
+		{ 0x90,	&hd6309::suba,			"SUBA" },
+		{ 0x91,	&hd6309::cmpa,			"CMPA" },
+		{ 0x92,	&hd6309::sbca,			"SBCA" },
+		{ 0x93,	&hd6309::subd,			"SUBD" },
+		{ 0x94,	&hd6309::anda,			"ANDA" },
+		{ 0x95,	&hd6309::bita,			"BITA" },
+		{ 0x96,	&hd6309::lda,			"LDA" },
+		{ 0x97,	&hd6309::sta,			"STA" },
+		{ 0x98,	&hd6309::eora,			"EORA" },
+		{ 0x99,	&hd6309::adca,			"ADCA" },
+		{ 0x9a,	&hd6309::ora,			"ORA" },
+		{ 0x9b,	&hd6309::adda,			"ADDA" },
+		{ 0x9c,	&hd6309::cmpx,			"CMPX" },
+		{ 0x9d,	&hd6309::jsr,			"JSR" },
+		{ 0x9e,	&hd6309::ldx,			"LDX" },
+		{ 0x9f,	&hd6309::stx,			"STX" },
+		{ 0xa0,	&hd6309::suba,			"SUBA" },
+		{ 0xa1,	&hd6309::cmpa,			"CMPA" },
+		{ 0xa2,	&hd6309::sbca,			"SBCA" },
+		{ 0xa3,	&hd6309::subd,			"SUBD" },
+		{ 0xa4,	&hd6309::anda,			"ANDA" },
+		{ 0xa5,	&hd6309::bita,			"BITA" },
+		{ 0xa6,	&hd6309::lda,			"LDA" },
+		{ 0xa7,	&hd6309::sta,			"STA" },
+		{ 0xa8,	&hd6309::eora,			"EORA" },
+		{ 0xa9,	&hd6309::adca,			"ADCA" },
+		{ 0xaa,	&hd6309::ora,			"ORA" },
+		{ 0xab,	&hd6309::adda,			"ADDA" },
+		{ 0xac,	&hd6309::cmpx,			"CMPX" },
+		{ 0xad,	&hd6309::jsr,			"JSR" },
+		{ 0xae,	&hd6309::ldx,			"LDX" },
+		{ 0xaf,	&hd6309::stx,			"STX" },
+		{ 0xb0,	&hd6309::suba,			"SUBA" },
+		{ 0xb1,	&hd6309::cmpa,			"CMPA" },
+		{ 0xb2,	&hd6309::sbca,			"SBCA" },
+		{ 0xb3,	&hd6309::subd,			"SUBD" },
+		{ 0xb4,	&hd6309::anda,			"ANDA" },
+		{ 0xb5,	&hd6309::bita,			"BITA" },
+		{ 0xb6,	&hd6309::lda,			"LDA" },
+		{ 0xb7,	&hd6309::sta,			"STA" },
+		{ 0xb8,	&hd6309::eora,			"EORA" },
+		{ 0xb9,	&hd6309::adca,			"ADCA" },
+		{ 0xba,	&hd6309::ora,			"ORA" },
+		{ 0xbb,	&hd6309::adda,			"ADDA" },
+		{ 0xbc,	&hd6309::cmpx,			"CMPX" },
+		{ 0xbd,	&hd6309::jsr,			"JSR" },
+		{ 0xbe,	&hd6309::ldx,			"LDX" },
+		{ 0xbf,	&hd6309::stx,			"STX" },
+		{ 0xc0,	&hd6309::subb,			"SUBB" },
+		{ 0xc1,	&hd6309::cmpb,			"CMPB" },
+		{ 0xc2,	&hd6309::sbcb,			"SBCB" },
+		{ 0xc3,	&hd6309::addd,			"ADDD" },
+		{ 0xc4,	&hd6309::andb,			"ANDB" },
+		{ 0xc5,	&hd6309::bitb,			"BITB" },
+		{ 0xc6,	&hd6309::ldb,			"LDB" },
+		{ 0xc8,	&hd6309::eorb,			"EORB" },
+		{ 0xc9,	&hd6309::adcb,			"ADCB" },
+		{ 0xca,	&hd6309::orb,			"ORB" },
+		{ 0xcb,	&hd6309::addb,			"ADDB" },
+		{ 0xcc,	&hd6309::ldd,			"LDD" },
+		{ 0xce,	&hd6309::ldu,			"LDU" },
+		{ 0xd0,	&hd6309::subb,			"SUBB" },
+		{ 0xd1,	&hd6309::cmpb,			"CMPB" },
+		{ 0xd2,	&hd6309::sbcb,			"SBCB" },
+		{ 0xd3,	&hd6309::addd,			"ADDD" },
+		{ 0xd4,	&hd6309::andb,			"ANDB" },
+		{ 0xd5,	&hd6309::bitb,			"BITB" },
+		{ 0xd6,	&hd6309::ldb,			"LDB" },
+		{ 0xd7,	&hd6309::stb,			"STB" },
+		{ 0xd8,	&hd6309::eorb,			"EORB" },
+		{ 0xd9,	&hd6309::adcb,			"ADCB" },
+		{ 0xda,	&hd6309::orb,			"ORB" },
+		{ 0xdb,	&hd6309::addb,			"ADDB" },
+		{ 0xdc,	&hd6309::ldd,			"LDD" },
+		{ 0xdd,	&hd6309::std,			"STD" },
+		{ 0xde,	&hd6309::ldu,			"LDU" },
+		{ 0xdf,	&hd6309::stu,			"STU" },
+		{ 0xe0,	&hd6309::subb,			"SUBB" },
+		{ 0xe1,	&hd6309::cmpb,			"CMPB" },
+		{ 0xe2,	&hd6309::sbcb,			"SBCB" },
+		{ 0xe3,	&hd6309::addd,			"ADDD" },
+		{ 0xe4,	&hd6309::andb,			"ANDB" },
+		{ 0xe5,	&hd6309::bitb,			"BITB" },
+		{ 0xe6,	&hd6309::ldb,			"LDB" },
+		{ 0xe7,	&hd6309::stb,			"STB" },
+		{ 0xe8,	&hd6309::eorb,			"EORB" },
+		{ 0xe9,	&hd6309::adcb,			"ADCB" },
+		{ 0xea,	&hd6309::orb,			"ORB" },
+		{ 0xeb,	&hd6309::addb,			"ADDB" },
+		{ 0xec,	&hd6309::ldd,			"LDD" },
+		{ 0xed,	&hd6309::std,			"STD" },
+		{ 0xee,	&hd6309::ldu,			"LDU" },
+		{ 0xef,	&hd6309::stu,			"STU" },
+		{ 0xf0,	&hd6309::subb,			"SUBB" },
+		{ 0xf1,	&hd6309::cmpb,			"CMPB" },
+		{ 0xf2,	&hd6309::sbcb,			"SBCB" },
+		{ 0xf3,	&hd6309::addd,			"ADDD" },
+		{ 0xf4,	&hd6309::andb,			"ANDB" },
+		{ 0xf5,	&hd6309::bitb,			"BITB" },
+		{ 0xf6,	&hd6309::ldb,			"LDB" },
+		{ 0xf7,	&hd6309::stb,			"STB" },
+		{ 0xf8,	&hd6309::eorb,			"EORB" },
+		{ 0xf9,	&hd6309::adcb,			"ADCB" },
+		{ 0xfa,	&hd6309::orb,			"ORB" },
+		{ 0xfb,	&hd6309::addb,			"ADDB" },
+		{ 0xfc,	&hd6309::ldd,			"LDD" },
+		{ 0xfd,	&hd6309::std,			"STD" },
+		{ 0xfe,	&hd6309::ldu,			"LDU" },
+		{ 0xff,	&hd6309::stu,			"STU" },
+
+		{ 0x1021,	&hd6309::lbrn,		"LBRN" },
+		{ 0x1022,	&hd6309::lbhi,		"LBHI" },
+		{ 0x1023,	&hd6309::lbls,		"LBLS" },
+		{ 0x1024,	&hd6309::lbcc,		"LBCC" },
+		{ 0x1025,	&hd6309::lbcs,		"LBCS" },
+		{ 0x1026,	&hd6309::lbne,		"LBNE" },
+		{ 0x1027,	&hd6309::lbeq,		"LBEQ" },
+		{ 0x1028,	&hd6309::lbvc,		"LBVC" },
+		{ 0x1029,	&hd6309::lbvs,		"LBVS" },
+		{ 0x102a,	&hd6309::lbpl,		"LBPL" },
+		{ 0x102b,	&hd6309::lbmi,		"LBMI" },
+		{ 0x102c,	&hd6309::lbge,		"LBGE" },
+		{ 0x102d,	&hd6309::lblt,		"LBLT" },
+		{ 0x102e,	&hd6309::lbgt,		"LBGT" },
+		{ 0x102f,	&hd6309::lble,		"LBLE" },
+		{ 0x103f,	&hd6309::swi2,		"SWI2" },
+		{ 0x1042,	&hd6309::coma,		"COMA" },	// undocumented
+		{ 0x1043,	&hd6309::comd,		":COMD" },
+		{ 0x1044,	&hd6309::lsrd,		":LSRD" },
+		{ 0x1046,	&hd6309::rord,		":RORD" },
+		{ 0x1048,	&hd6309::lsld,		":LSLD" },
+		{ 0x1049,	&hd6309::rold,		":ROLD" },
+		{ 0x104a,	&hd6309::decd,		":DECD" },
+		{ 0x104c,	&hd6309::incd,		":INCD" },
+		{ 0x104d,	&hd6309::tstd,		":TSTD" },
+		{ 0x104f,	&hd6309::clrd,		":CLRD" },
+		{ 0x1053,	&hd6309::comw,		":COMW" },
+		{ 0x1054,	&hd6309::lsrw,		":LSRW" },
+		{ 0x1056,	&hd6309::rorw,		":RORW" },
+		{ 0x1059,	&hd6309::rolw,		":ROLD" },
+		{ 0x105a,	&hd6309::decw,		":DECW" },
+		{ 0x105c,	&hd6309::incw,		":INCW" },
+		{ 0x105d,	&hd6309::tstw,		":TSTW" },
+		{ 0x105f,	&hd6309::clrw,		":CLRW" },
+		{ 0x1080,	&hd6309::subw,		":SUBW" },
+		{ 0x1081,	&hd6309::cmpw,		"CMPW" },
+		{ 0x1082,	&hd6309::sbcd,		":SBCD" },
+		{ 0x1083,	&hd6309::cmpd,		"CMPD" },
+		{ 0x1084,	&hd6309::andd,		":ANDD" },
+		{ 0x1085,	&hd6309::bitd,		":BITD" },
+		{ 0x1086,	&hd6309::ldw,		":LDW" },
+		{ 0x1088,	&hd6309::eord,		":EORD" },
+		{ 0x108a,	&hd6309::ord,		":ORD" },
+		{ 0x108b,	&hd6309::addw,		":ADDW" },
+		{ 0x108c,	&hd6309::cmpy,		"CMPY" },
+		{ 0x108e,	&hd6309::ldy,		"LDY" },
+		{ 0x1090,	&hd6309::subw,		":SUBW" },
+		{ 0x1091,	&hd6309::cmpw,		"CMPW" },
+		{ 0x1092,	&hd6309::sbcd,		":SBCD" },
+		{ 0x1093,	&hd6309::cmpd,		"CMPD" },
+		{ 0x1094,	&hd6309::andd,		":ANDD" },
+		{ 0x1095,	&hd6309::bitd,		":BITD" },
+		{ 0x1096,	&hd6309::ldw,		":LDW" },
+		{ 0x1097,	&hd6309::stw,		":STW" },
+		{ 0x1098,	&hd6309::eord,		":EORD" },
+		{ 0x109a,	&hd6309::ord,		":ORD" },
+		{ 0x109b,	&hd6309::addw,		":ADDW" },
+		{ 0x109c,	&hd6309::cmpy,		"CMPY" },
+		{ 0x109e,	&hd6309::ldy,		"LDY" },
+		{ 0x109f,	&hd6309::sty,		"STY" },
+		{ 0x10a0,	&hd6309::subw,		":SUBW" },
+		{ 0x10a1,	&hd6309::cmpw,		"CMPW" },
+		{ 0x10a2,	&hd6309::sbcd,		":SBCD" },
+		{ 0x10a3,	&hd6309::cmpd,		"CMPD" },
+		{ 0x10a4,	&hd6309::andd,		":ANDD" },
+		{ 0x10a5,	&hd6309::bitd,		":BITD" },
+		{ 0x10a6,	&hd6309::ldw,		":LDW" },
+		{ 0x10a7,	&hd6309::stw,		":STW" },
+		{ 0x10a8,	&hd6309::eord,		":EORD" },
+		{ 0x10aa,	&hd6309::ord,		":ORD" },
+		{ 0x10ab,	&hd6309::addw,		":ADDW" },
+		{ 0x10ac,	&hd6309::cmpy,		"CMPY" },
+		{ 0x10ae,	&hd6309::ldy,		"LDY" },
+		{ 0x10af,	&hd6309::sty,		"STY" },
+		{ 0x10b0,	&hd6309::subw,		":SUBW" },
+		{ 0x10b1,	&hd6309::cmpw,		"CMPW" },
+		{ 0x10b2,	&hd6309::sbcd,		":SBCD" },
+		{ 0x10b3,	&hd6309::cmpd,		"CMPD" },
+		{ 0x10b4,	&hd6309::andd,		":ANDD" },
+		{ 0x10b5,	&hd6309::bitd,		":BITD" },
+		{ 0x10b6,	&hd6309::ldw,		":LDW" },
+		{ 0x10b7,	&hd6309::stw,		":STW" },
+		{ 0x10b8,	&hd6309::eord,		":EORD" },
+		{ 0x10ba,	&hd6309::ord,		":ORD" },
+		{ 0x10bb,	&hd6309::addw,		":ADDW" },
+		{ 0x10bc,	&hd6309::cmpy,		"CMPY" },
+		{ 0x10be,	&hd6309::ldy,		"LDY" },
+		{ 0x10bf,	&hd6309::sty,		"STY" },
+		{ 0x10ce,	&hd6309::lds,		"LDS" },
+		{ 0x10de,	&hd6309::lds,		"LDS" },
+		{ 0x10df,	&hd6309::sts,		"STS" },
+		{ 0x10ee,	&hd6309::lds,		"LDS" },
+		{ 0x10ef,	&hd6309::sts,		"STS" },
+		{ 0x10fe,	&hd6309::lds,		"LDS" },
+		{ 0x10ff,	&hd6309::sts,		"STS" },
+
+		{ 0x113c,	&hd6309::bitmd,		":BITMD" },
+		{ 0x113d,	&hd6309::ldmd,		":LDMD" },
+		{ 0x113f,	&hd6309::swi3,		"SWI3" },
+		{ 0x1143,	&hd6309::come,		":COME" },
+		{ 0x114a,	&hd6309::dece,		":DECE" },
+		{ 0x114c,	&hd6309::ince,		":INCE" },
+		{ 0x114d,	&hd6309::tste,		":TSTE" },
+		{ 0x114f,	&hd6309::clre,		":CLRE" },
+		{ 0x1153,	&hd6309::comf,		":COMF" },
+		{ 0x115a,	&hd6309::decf,		":DECF" },
+		{ 0x115c,	&hd6309::incf,		":INCF" },
+		{ 0x115d,	&hd6309::tstf,		":TSTF" },
+		{ 0x115f,	&hd6309::clrf,		":CLRF" },
+		{ 0x1180,	&hd6309::sube,		":SUBE" },
+		{ 0x1181,	&hd6309::cmpe,		":CMPE" },
+		{ 0x1183,	&hd6309::cmpu,		"CMPU" },
+		{ 0x1186,	&hd6309::lde,		":LDE" },
+		{ 0x118b,	&hd6309::adde,		":ADDE" },
+		{ 0x118c,	&hd6309::cmps,		"CMPS" },
+		{ 0x1190,	&hd6309::sube,		":SUBE" },
+		{ 0x1191,	&hd6309::cmpe,		":CMPE" },
+		{ 0x1193,	&hd6309::cmpu,		"CMPU" },
+		{ 0x1196,	&hd6309::lde,		":LDE" },
+		{ 0x1197,	&hd6309::ste,		":STE" },
+		{ 0x119b,	&hd6309::adde,		":ADDE" },
+		{ 0x119c,	&hd6309::cmps,		"CMPS" },
+		{ 0x11a0,	&hd6309::sube,		":SUBE" },
+		{ 0x11a1,	&hd6309::cmpe,		":CMPE" },
+		{ 0x11a3,	&hd6309::cmpu,		"CMPU" },
+		{ 0x11a6,	&hd6309::lde,		":LDE" },
+		{ 0x11a7,	&hd6309::ste,		":STE" },
+		{ 0x11ab,	&hd6309::adde,		":ADDE" },
+		{ 0x11ac,	&hd6309::cmps,		"CMPS" },
+		{ 0x11b0,	&hd6309::sube,		":SUBE" },
+		{ 0x11b1,	&hd6309::cmpe,		":CMPE" },
+		{ 0x11b3,	&hd6309::cmpu,		"CMPU" },
+		{ 0x11b6,	&hd6309::lde,		":LDE" },
+		{ 0x11b7,	&hd6309::ste,		":STE" },
+		{ 0x11bb,	&hd6309::adde,		":ADDE" },
+		{ 0x11bc,	&hd6309::cmps,		"CMPS" },
+		{ 0x11c0,	&hd6309::subf,		"SUBF" },
+		{ 0x11c1,	&hd6309::cmpf,		":CMPF" },
+		{ 0x11c6,	&hd6309::ldf,		":LDF" },
+		{ 0x11cb,	&hd6309::addf,		":ADDF" },
+		{ 0x11d0,	&hd6309::subf,		"SUBF" },
+		{ 0x11d1,	&hd6309::cmpf,		":CMPF" },
+		{ 0x11d6,	&hd6309::ldf,		":LDF" },
+		{ 0x11d7,	&hd6309::stf,		":STF" },
+		{ 0x11db,	&hd6309::addf,		":ADDF" },
+		{ 0x11e0,	&hd6309::subf,		"SUBF" },
+		{ 0x11e1,	&hd6309::cmpf,		":CMPF" },
+		{ 0x11e6,	&hd6309::ldf,		":LDF" },
+		{ 0x11e7,	&hd6309::stf,		":STF" },
+		{ 0x11eb,	&hd6309::addf,		":ADDF" },
+		{ 0x11f0,	&hd6309::subf,		"SUBF" },
+		{ 0x11f1,	&hd6309::cmpf,		":CMPF" },
+		{ 0x11f6,	&hd6309::ldf,		":LDF" },
+		{ 0x11f7,	&hd6309::stf,		":STF" },
+		{ 0x11fb,	&hd6309::addf,		":ADDF" },
+	};
+
+	static const std::vector<opcode> table = [] {
+		std::vector<opcode> t(3 * 256);
+
+		for (Word page = 0; page < 3; ++page) {
+			Word prefix = page ? (page + 0x0f) << 8 : 0;
+			for (Word i = 0; i < 256; ++i) {
+				t[page * 256 + i] = { &hd6309::nop, decode_mode(prefix | i), "NOP" };
+			}
+		}
+
+		for (auto& def : defs) {
+			Word page = (def.ir >> 8) ? (def.ir >> 8) - 0x0f : 0;
+			t[page * 256 + (def.ir & 0xff)] = { def.handler, decode_mode(def.ir), def.mnemonic };
+		}
+
+		return t;
+	}();
+
+	return table.data();
+}
+
+// A backward branch taken again from the same register state,
+// with nothing written in between, is in a loop that will keep
+// going round unchanged until some device next acts, so skip
+// as many whole iterations as fit before then
+void hd6309::check_idle_loop()
+{
+	loop_state state = { q, insn_pc, x, y, u, s, dp, cc.all, md.all, lazy, side_effects };
+
+	// nothing has been recorded while idle_loop_instructions is zero
+	if (idle_loop_instructions && state == idle_loop && !m_trace && !tracer) {
+		uint64_t n = skip_idle(clock.now - idle_loop_time);
+		instructions += n * (instructions - idle_loop_instructions);
+	}
+
+	idle_loop = state;
+	idle_loop_time = clock.now;
+	idle_loop_instructions = instructions;
+}
+
+bool hd6309::loop_state::operator==(const loop_state& o) const
+{
+	return q == o.q && pc == o.pc && x == o.x && y == o.y &&
+		u == o.u && s == o.s && dp == o.dp && cc == o.cc && md == o.md &&
+		lazy.width == o.lazy.width && lazy.half == o.lazy.half &&
+		lazy.x == o.lazy.x && lazy.m == o.lazy.m && lazy.t == o.lazy.t &&
+		side_effects == o.side_effects;
+}
+
+void hd6309::eval_deferred_cc()
+{
+	if (lazy.half) {
+		cc.bit.h = btst((Word)(lazy.x ^ lazy.m ^ lazy.t), 4);
 	}
+	cc.bit.c = flag_c();
+	cc.bit.v = flag_v();
+	cc.bit.z = flag_z();
+	cc.bit.n = flag_n();
+	lazy.width = 0;
+	lazy.half = false;
 }
 
 void hd6309::print_regs()
 {
+	eval_cc();
 	char flags[] = "EFHINZVC";
 	for (uint8_t i = 0, mask = 0x80; mask; ++i, mask >>= 1) {
 		if ((cc.all & mask) == 0) {
@@ -578,23 +840,53 @@ void hd6309::print_regs()
 
 void hd6309::pre_exec()
 {
+	if (tracer) {
+		record_regs(tracer->next());
+	}
+
 	if (!m_trace) return;
 
 	print_regs();
+
+	Byte code[5];
+	peek(pc, code, sizeof code);
+	disasm.decode(code, sizeof code, pc, traced);
 }
 
 void hd6309::post_exec()
 {
+	if (tracer) {
+		tracer->next().cycles = cycles;
+		tracer->commit();
+	}
+
 	if (!m_trace) return;
 
-	fprintf(stderr, "/ %04X: [%2d] %-8s%s\r\n", insn_pc, cycles, insn, disasm_operand().c_str());
+	fprintf(stderr, "/ %04X: [%2d] %-8s%s\r\n", insn_pc, cycles, traced.mnemonic, traced.operand);
+}
+
+// the binary trace equivalent of print_regs()
+void hd6309::record_regs(TraceRecord& r)
+{
+	eval_cc();
+	r.time = clock.now;
+	r.pc = pc;
+	r.cc = cc.all;
+	r.s = s;
+	r.u = u;
+	r.a = a;
+	r.b = b;
+	r.e = e;
+	r.f = f;
+	r.x = x;
+	r.y = y;
+	r.dp = dp;
+	peek(pc, r.code, sizeof r.code);
 }
 
 // used for EXG and TFR instructions
 Word& hd6309::wordrefreg(int r)
 {
-	static Word no_return = 0;
-
 	switch (r) {
 		case  0: return d;
 		case  1: return x;
@@ -605,29 +897,25 @@ Word& hd6309::wordrefreg(int r)
 	}
 
 	invalid("invalid word register selector");
-	return no_return;
+	return no_return_word;
 }
 
 Byte& hd6309::byterefreg(int r)
 {
-	static Byte no_return = 0;
-
 	switch (r) {
 		case  8: return a;
 		case  9: return b;
-		case 10: return cc.all;
+		case 10: eval_cc(); return cc.all;
 		case 11: return dp;
 	}
 
 	invalid("invalid byte register selector");
-	return no_return;
+	return no_return_byte;
 }
 
 // decodes the postbyte for most indexed modes
 Word& hd6309::ix_refreg(Byte post)
 {
-	static Word no_return = 0;
-
 	post = (post >> 5) & 0x03;
 	switch (post) {
 		case 0: return x;
@@ -637,16 +925,16 @@ Word& hd6309::ix_refreg(Byte post)
 	}
 
 	invalid("invalid register reference");
-	return no_return;
+	return no_return_word;
 }
 
 Byte hd6309::fetch_operand()
 {
 	switch (mode) {
 		case immediate:
-			return operand = extend8(fetch());
+			return operand = extend8(fetch_operand_byte());
 		case relative: {
-			Byte r = fetch();
+			Byte r = fetch_operand_byte();
 			operand = pc + extend8(r);
 			return r;
 		}
@@ -659,9 +947,9 @@ Word hd6309::fetch_word_operand()
 {
 	switch (mode) {
 		case immediate:
-			return operand = fetch_word();
+			return operand = fetch_operand_word();
 		case relative: {
-			Word r = fetch_word();
+			Word r = fetch_operand_word();
 			operand = pc + r;
 			return r;
 		}
@@ -675,13 +963,13 @@ Word hd6309::fetch_effective_address()
 	switch (mode) {
 		case extended:
 			++cycles;
-			return operand = fetch_word();
+			return operand = fetch_operand_word();
 		case direct:
 			++cycles;
-			operand = fetch();
+			operand = fetch_operand_byte();
 			return ((Word)dp << 8) | operand;
 		case indexed: {
-			post = fetch();
+			post = fetch_postbyte();
 
 			do_predecrement();
 			Word addr = fetch_indexed_operand();
@@ -732,26 +1020,26 @@ Word hd6309::fetch_indexed_operand()
 			return extend8(a) + ix_refreg(post);
 		case 0x08: case 0x18:		// ,R + 8 bit
 			cycles += 1;
-			operand = extend8(fetch());
+			operand = extend8(fetch_operand_byte());
 			return ix_refreg(post) + operand;
 		case 0x09: case 0x19:		// ,R + 16 bit
 			cycles += 3;
-			operand = fetch_word();
+			operand = fetch_operand_word();
 			return ix_refreg(post) + operand;
 		case 0x0b: case 0x1b:		// ,R + D
 			cycles += 5;
 			return d + ix_refreg(post);
 		case 0x0c: case 0x1c:		// ,PC + 8
 			cycles += 1;
-			operand = extend8(fetch());
+			operand = extend8(fetch_operand_byte());
 			return pc + operand;
 		case 0x0d: case 0x1d:		// ,PC + 16
 			cycles += 3;
-			operand = fetch_word();
+			operand = fetch_operand_word();
 			return pc + operand;
 		case 0x1f:			// [,Address]
 			cycles += 1;
-			operand = fetch_word();
+			operand = fetch_operand_word();
 			return operand;
 		default:
 			invalid("invalid indexed addressing postbyte");
@@ -788,130 +1076,3 @@ void hd6309::do_predecrement()
 			break;
 	}
 }
-
-//---------------------------------------------------------------------
-//
-// disassembly support
-//
-//---------------------------------------------------------------------
-
-static std::string disasm_reglist(Byte w, const char *other_sr)
-{
-        static const char* regs[]  = {
-                "CC", "A", "B", "DP", "X", "Y", "", "PC"
-        };
-
-        std::string r;
-
-        for (int n = 0; (n < 8) && w; ++n, w >>= 1) {
-                if (w & 1) {
-                        r += (n == 6) ? other_sr : regs[n];
-                        if (w & 0xfe) {
-                                r += ",";
-                        }
-                }
-        }
-
-        return r;
-}
-
-static std::string disasm_regpair(Byte w)
-{
-	static const char* regnames[] = {
-		"D", "X", "Y", "U", "S", "PC", "", "",
-		"A", "B", "CC", "DP", "", "", "", ""
-	};
-
-	int r1 = (w & 0xf0) >> 4;
-	int r2 = (w & 0x0f) >> 0;
-
-	return std::string(regnames[r1]) + "," + std::string(regnames[r2]);
-}
-
-template<typename ... Args>
-static std::string fmt(const std::string& format, Args ... args)
-{
-	int size = ::snprintf(nullptr, 0, format.c_str(), args ...) + 1;
-	if (size <= 0) {
-		return "string formatting error";
-	}
-
-	std::unique_ptr<char[]> buf(new char[size]);
-	::snprintf(buf.get(), size, format.c_str(), args ...);
-	return std::string(buf.get(), buf.get() + size - 1 );
-}
-
-std::string hd6309::disasm_indexed()
-{
-	static const char regs[] = "XYUS";
-	const char reg = regs[(post >> 5) & 0x03];
-
-	if (!btst(post, 7)) {			// ,R + 5 bit offset
-		return fmt("%d,%c", (int16_t)extend5(post & 0x1f), reg);
-	}
-
-	switch (post & 0x1f) {
-		case 0x00:			// ,R+
-			return fmt(",%c+", reg);
-		case 0x01: case 0x11:		// ,R++
-			return fmt(",%c++", reg);
-		case 0x02:			// ,-R
-			return fmt(",-%c", reg);
-		case 0x03: case 0x13:		// ,--R
-			return fmt(",--%c", reg);
-		case 0x04: case 0x14:		// ,R + 0
-			return fmt(",%c", reg);
-		case 0x05: case 0x15:		// ,R + B
-			return fmt("B,%c", reg);
-		case 0x06: case 0x16:		// ,R + A
-			return fmt("A,%c", reg);
-		case 0x08: case 0x18:		// ,R + offset
-		case 0x09: case 0x19:
-			return fmt("%d,%c", (int16_t)operand, reg);
-		case 0x0b: case 0x1b:		// ,R + D
-			return fmt("D,%c", reg);
-		case 0x0c: case 0x1c:		// ,PCR + offset
-		case 0x0d: case 0x1d:
-			return fmt("%d,PCR", (int16_t)operand, reg);
-		case 0x1f:			// ,Address
-			return fmt(",$%04hx", (int16_t)operand);
-		default:
-			invalid("indirect addressing postbyte");
-			return "";
-	}
-}
-
-std::string hd6309::disasm_operand()
-{
-	// special cases for PSHx / PULx / EXG / TFR
-	switch (ir) {
-		case 0x34: case 0x36:	// PSHS / PULS
-			return disasm_reglist(operand, "U");
-		case 0x35: case 0x37:	// PSHU / PULU
-			return disasm_reglist(operand, "S");
-		case 0x1e: case 0x1f:	// EXG / TFR
-			return disasm_regpair(operand);
-	}
-
-	switch (mode) {
-		case inherent:
-			return "";
-		case immediate:
-			return fmt("#$%02X", operand);
-		case relative:
-			return fmt("$%04X", operand);
-		case direct:
-			return fmt("<$%02X", operand);
-		case extended:
-			return fmt("$%04X", operand);
-		case indexed: {
-			auto r = disasm_indexed();
-			if (btst(post, 4) && btst(post, 7)) {
-				r = "[" + r + "]";
-			}
-			return r;
-		}
-	}
-
-	return "";
-}
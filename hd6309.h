@@ -9,8 +9,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "wiring.h"
 #include "usim.h"
+#include "disasm.h"
 #include "bits.h"
 
 #ifndef USIM_MACHDEP_H
@@ -21,7 +23,7 @@ class hd6309 : virtual public USimMotorola {
 
 protected: // Processor addressing modes
 
-	enum {
+	enum addressing_mode {
 				immediate,
 				direct,
 				indexed,
@@ -113,15 +115,96 @@ protected:	// Processor registers
         } bit;
     } md;
 
+protected:	// lazily evaluated condition codes
+	//
+	// the common arithmetic instructions only record their operands
+	// and result here, and N, Z, V, C (and H for 8 bit additions) are
+	// worked out when something actually looks at them.  Code that
+	// reads or partially updates those bits of cc must call eval_cc()
+	// first.
+	struct deferred_cc {
+		Byte		width;		// 8 or 16, 0 if cc is up to date
+		bool		half;		// H is deferred too
+		Word		x, m;		// operands
+		int		t;		// untruncated result
+	};
+
+	deferred_cc		lazy = {};
+
+	void			defer_cc(Byte width, bool half, Word x, Word m, int t);
+	void			eval_cc();
+	void			eval_deferred_cc();
+
+	bool			flag_c() const;
+	bool			flag_v() const;
+	bool			flag_z() const;
+	bool			flag_n() const;
+
+protected:	// idle loop detection
+	struct loop_state {
+		DWord		q;
+		Word		pc, x, y, u, s;
+		Byte		dp, cc, md;
+		deferred_cc	lazy;
+		uint32_t	side_effects;
+
+		bool		operator==(const loop_state&) const;
+	};
+
+	loop_state		idle_loop = {};
+	Cycles			idle_loop_time = 0;
+	uint64_t		idle_loop_instructions = 0;
+
+	void			check_idle_loop();
+
 private:	// internal processor state
 	bool			waiting_sync;
 	bool			waiting_cwai;
 	bool			nmi_previous;
 
+	Word			no_return_word = 0;	// given out for invalid
+	Byte			no_return_byte = 0;	// register selectors
+
+protected:	// opcode dispatch table
+	struct opcode {
+		void		(hd6309::*handler)();
+		addressing_mode	mode;
+		const char*	mnemonic;
+	};
+
+	static addressing_mode	decode_mode(Word);
+	static const opcode*	opcode_table();
+
+	const opcode*		opcodes;	// pages 0x00, 0x10 and 0x11
+	const opcode*		op;		// current instruction
+
+protected:	// predecoded instruction cache
+	struct decoded {
+		const opcode*	op;		// nullptr if not (yet) valid
+		uint32_t	gen;		// page generation when decoded
+		Word		ir;
+		Word		arg;		// operand bytes following any postbyte
+		Byte		post;
+		Byte		length;		// total instruction bytes
+		Byte		opcode_length;
+	};
+
+	std::vector<decoded>	predecoded;	// empty unless enabled
+	decoded*		recording = nullptr;
+	const decoded*		replaying = nullptr;
+
+	void			execute_predecoded();
+
 private:	// instruction and operand fetch and decode
 	Word&			ix_refreg(Byte);
 
+	void			step();
+	template<typename Done>
+	Cycles			run_while_not(Done done);
 	void			fetch_instruction();
+	Byte			fetch_postbyte();
+	Byte			fetch_operand_byte();
+	Word			fetch_operand_word();
 	Byte			fetch_operand();
 	Word			fetch_word_operand();
 	Word			fetch_effective_address();
@@ -260,11 +343,18 @@ protected: 	// instruction tracing
 	Byte			post;
 	Word			operand;
 
-	std::string		disasm_operand();
-	std::string		disasm_indexed();
+	Disassembler		disasm;
+	Disassembly		traced;		// the instruction being traced
+
+	void			record_regs(TraceRecord&);
+
+protected:	// snapshots
+	virtual void		save_state(StateBuffer& state);
+	virtual void		restore_state(StateReader& state);
 
 public:		// external signal pins
-	InputPin		IRQ, FIRQ, NMI;
+	InputPin		IRQ, FIRQ, NMI;		// polled, if bound
+	InputLine		IRQ_line, FIRQ_line, NMI_line;	// pushed
 
 public:
 					hd6309();		// public constructor
@@ -273,18 +363,123 @@ public:
 	virtual void	reset();		// CPU reset
 	virtual void	tick();
 
+	virtual void	run();
+	virtual Cycles	run_for(Cycles n);
+	virtual Cycles	run_until(Word addr);
+	virtual Cycles	run_until(const std::function<bool()>& done);
+
 	virtual void	print_regs();
 
+	void			predecode_on();
+	void			predecode_off();
+
 	Byte&			byterefreg(int);
 	Word&			wordrefreg(int);
 
 };
 
+//---------------------------------------------------------------------
+//
+// instruction stream fetches, served from the predecoded cache when
+// replaying and remembered in it when recording
+//
+//---------------------------------------------------------------------
+
+inline Byte hd6309::fetch_postbyte()
+{
+	if (replaying) {
+		++cycles;
+		return replaying->post;
+	}
+
+	Byte val = fetch();
+	if (recording) {
+		recording->post = val;
+		++recording->length;
+	}
+	return val;
+}
+
+inline Byte hd6309::fetch_operand_byte()
+{
+	if (replaying) {
+		++cycles;
+		return (Byte)replaying->arg;
+	}
+
+	Byte val = fetch();
+	if (recording) {
+		recording->arg = val;
+		++recording->length;
+	}
+	return val;
+}
+
+inline Word hd6309::fetch_operand_word()
+{
+	if (replaying) {
+		cycles += 2;
+		return replaying->arg;
+	}
+
+	Word val = fetch_word();
+	if (recording) {
+		recording->arg = val;
+		recording->length += 2;
+	}
+	return val;
+}
+
+//---------------------------------------------------------------------
+//
+// lazily evaluated condition codes
+//
+//---------------------------------------------------------------------
+
+inline void hd6309::defer_cc(Byte width, bool half, Word x, Word m, int t)
+{
+	// H survives everything other than 8 bit additions
+	if (lazy.half && !half) {
+		cc.bit.h = btst((Word)(lazy.x ^ lazy.m ^ lazy.t), 4);
+	}
+	lazy = { width, half, x, m, t };
+}
+
+inline void hd6309::eval_cc()
+{
+	if (lazy.width) {
+		eval_deferred_cc();
+	}
+}
+
+inline bool hd6309::flag_c() const
+{
+	return lazy.width ? (lazy.t >> lazy.width) & 1 : cc.bit.c;
+}
+
+inline bool hd6309::flag_v() const
+{
+	return lazy.width ? ((lazy.x ^ lazy.m ^ lazy.t ^ (lazy.t >> 1)) >> (lazy.width - 1)) & 1 : cc.bit.v;
+}
+
+inline bool hd6309::flag_z() const
+{
+	return lazy.width ? !(lazy.t & ((1 << lazy.width) - 1)) : cc.bit.z;
+}
+
+inline bool hd6309::flag_n() const
+{
+	return lazy.width ? (lazy.t >> (lazy.width - 1)) & 1 : cc.bit.n;
+}
+
 inline void hd6309::do_br(const char *mnemonic, bool test)
 {
 	(void)mnemonic;
 	Word offset = extend8(fetch_operand());
-	if (test) pc += offset;
+	if (test) {
+		if (offset & 0x8000) check_idle_loop();
+		pc += offset;
+	}
 	++cycles;
 }
 
@@ -293,6 +488,7 @@ inline void hd6309::do_lbr(const char *mnemonic, bool test)
 	(void)mnemonic;
 	Word offset = fetch_word_operand();
 	if (test) {
+		if (offset & 0x8000) check_idle_loop();
 		pc += offset;
 		++cycles;
 	}
@@ -16,55 +16,24 @@
 void hd6309::help_adc(Byte& x)
 {
 	Byte	m = fetch_operand();
+	int	t = x + m + flag_c();
 
-	{
-		Byte	t = (x & 0x0f) + (m & 0x0f) + cc.bit.c;
-		cc.bit.h = btst(t, 4);		// Half carry
-	}
-
-	{
-		Byte	t = (x & 0x7f) + (m & 0x7f) + cc.bit.c;
-		cc.bit.v = btst(t, 7);		// Bit 7 carry in
-	}
-
-	{
-		Word	t = x + m + cc.bit.c;
-		cc.bit.c = btst(t, 8);		// Bit 7 carry out
-		x = t & 0xff;
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(x, 7);
-	cc.bit.z = !x;
+	defer_cc(8, true, x, m, t);
+	x = t & 0xff;
 }
 
 void hd6309::help_add(Byte& x)
 {
 	Byte	m = fetch_operand();
+	int	t = x + m;
 
-	{
-		Byte	t = (x & 0x0f) + (m & 0x0f);
-		cc.bit.h = btst(t, 4);		// Half carry
-	}
-
-	{
-		Byte	t = (x & 0x7f) + (m & 0x7f);
-		cc.bit.v = btst(t, 7);		// Bit 7 carry in
-	}
-
-	{
-		Word	t = x + m;
-		cc.bit.c = btst(t, 8);		// Bit 7 carry out
-		x = t & 0xff;
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(x, 7);
-	cc.bit.z = !x;
+	defer_cc(8, true, x, m, t);
+	x = t & 0xff;
 }
 
 void hd6309::help_and(Byte& x)
 {
+	eval_cc();
 	x = x & fetch_operand();
 	cc.bit.n = btst(x, 7);
 	cc.bit.z = !x;
@@ -73,6 +42,7 @@ void hd6309::help_and(Byte& x)
 
 void hd6309::help_and(Word& x)
 {
+	eval_cc();
 	x = x & fetch_operand();
 	cc.bit.n = btst(x, 15);
 	cc.bit.z = !x;
@@ -81,6 +51,7 @@ void hd6309::help_and(Word& x)
 
 void hd6309::help_asr(Byte& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 0);
 	x >>= 1;	/* Shift word right */
 	if ((cc.bit.n = btst(x, 6)) != 0) {
@@ -92,6 +63,7 @@ void hd6309::help_asr(Byte& x)
 
 void hd6309::help_bit(Byte x)
 {
+	eval_cc();
 	Byte t = x & fetch_operand();
 	cc.bit.n = btst(t, 7);
 	cc.bit.v = 0;
@@ -100,6 +72,7 @@ void hd6309::help_bit(Byte x)
 
 void hd6309::help_bit(Word x)
 {
+	eval_cc();
 	Word t = x & fetch_word_operand();
 	cc.bit.n = btst(t, 15);
 	cc.bit.v = 0;
@@ -108,6 +81,7 @@ void hd6309::help_bit(Word x)
 
 void hd6309::help_clr(Byte& x)
 {
+	eval_cc();
 	cc.all &= 0xf0;
 	cc.all |= 0x04;
 	x = 0;
@@ -116,6 +90,7 @@ void hd6309::help_clr(Byte& x)
 
 void hd6309::help_clr(Word& x)
 {
+	eval_cc();
 	cc.all &= 0xf0;
 	cc.all |= 0x04;
 	x = 0;
@@ -127,26 +102,21 @@ void hd6309::help_cmp(Byte x)
 	Byte	m = fetch_operand();
 	int	t = x - m;
 
-	cc.bit.v = btst((Byte)(x ^ m ^ t ^ (t >> 1)), 7);
-	cc.bit.c = btst((Word)t, 8);
-	cc.bit.n = btst((Byte)t, 7);
-	cc.bit.z = !(t & 0xff);
+	defer_cc(8, false, x, m, t);
 }
 
 void hd6309::help_cmp(Word x)
 {
 	Word	m = fetch_word_operand();
-	long	t = x - m;
+	int	t = x - m;
 
-	cc.bit.v = btst((DWord)(x ^ m ^ t ^ (t >> 1)), 15);
-	cc.bit.c = btst((DWord)t, 16);
-	cc.bit.n = btst((DWord)t, 15);
-	cc.bit.z = !(t & 0xffff);
+	defer_cc(16, false, x, m, t);
 	++cycles;
 }
 
 void hd6309::help_com(Byte& x)
 {
+	eval_cc();
 	x = ~x;
 	cc.bit.c = 1;
 	cc.bit.v = 0;
@@ -157,6 +127,7 @@ void hd6309::help_com(Byte& x)
 
 void hd6309::help_com(Word& x)
 {
+	eval_cc();
 	x = ~x;
 	cc.bit.c = 1;
 	cc.bit.v = 0;
@@ -167,6 +138,7 @@ void hd6309::help_com(Word& x)
 
 void hd6309::help_dec(Byte& x)
 {
+	eval_cc();
 	cc.bit.v = (x == 0x80);
 	x = x - 1;
 	cc.bit.n = btst(x, 7);
@@ -176,6 +148,7 @@ void hd6309::help_dec(Byte& x)
 
 void hd6309::help_dec(Word& x)
 {
+	eval_cc();
 	cc.bit.v = (x == 0x8000);
 	x = x - 1;
 	cc.bit.n = btst(x, 15);
@@ -185,6 +158,7 @@ void hd6309::help_dec(Word& x)
 
 void hd6309::help_eor(Byte& x)
 {
+	eval_cc();
 	x = x ^ fetch_operand();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 7);
@@ -193,6 +167,7 @@ void hd6309::help_eor(Byte& x)
 
 void hd6309::help_eor(Word& x)
 {
+	eval_cc();
 	x = x ^ fetch_operand();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 15);
@@ -201,6 +176,7 @@ void hd6309::help_eor(Word& x)
 
 void hd6309::help_inc(Byte& x)
 {
+	eval_cc();
 	cc.bit.v = (x == 0x7f);
 	x = x + 1;
 	cc.bit.n = btst(x, 7);
@@ -210,6 +186,7 @@ void hd6309::help_inc(Byte& x)
 
 void hd6309::help_inc(Word& x)
 {
+	eval_cc();
 	cc.bit.v = (x == 0x7fff);
 	x = x + 1;
 	cc.bit.n = btst(x, 15);
@@ -219,6 +196,7 @@ void hd6309::help_inc(Word& x)
 
 void hd6309::help_ld(Byte& x)
 {
+	eval_cc();
 	x = fetch_operand();
 	cc.bit.n = btst(x, 7);
 	cc.bit.v = 0;
@@ -227,6 +205,7 @@ void hd6309::help_ld(Byte& x)
 
 void hd6309::help_ld(Word& x)
 {
+	eval_cc();
 	x = fetch_word_operand();
 	cc.bit.n = btst(x, 15);
 	cc.bit.v = 0;
@@ -235,6 +214,7 @@ void hd6309::help_ld(Word& x)
 
 void hd6309::help_lsl(Byte& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 7);
 	cc.bit.v = btst(x, 7) ^ btst(x, 6);
 	x <<= 1;
@@ -245,6 +225,7 @@ void hd6309::help_lsl(Byte& x)
 
 void hd6309::help_lsl(Word& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 15);
 	cc.bit.v = btst(x, 15) ^ btst(x, 14);
 	x <<= 1;
@@ -255,6 +236,7 @@ void hd6309::help_lsl(Word& x)
 
 void hd6309::help_lsr(Byte& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 0);
 	x >>= 1;	/* Shift word right */
 	cc.bit.n = 0;
@@ -264,6 +246,7 @@ void hd6309::help_lsr(Byte& x)
 
 void hd6309::help_lsr(Word& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 0);
 	x >>= 1;	/* Shift word right */
 	cc.bit.n = 0;
@@ -273,6 +256,7 @@ void hd6309::help_lsr(Word& x)
 
 void hd6309::help_neg(Byte& x)
 {
+	eval_cc();
 	int	t = 0 - x;
 
 	cc.bit.v = btst((Byte)(x ^ t ^ (t >> 1)), 7);
@@ -285,6 +269,7 @@ void hd6309::help_neg(Byte& x)
 
 void hd6309::help_or(Byte& x)
 {
+	eval_cc();
 	x = x | fetch_operand();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 7);
@@ -293,6 +278,7 @@ void hd6309::help_or(Byte& x)
 
 void hd6309::help_or(Word& x)
 {
+	eval_cc();
 	x = x | fetch_operand();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 15);
@@ -301,6 +287,7 @@ void hd6309::help_or(Word& x)
 
 void hd6309::help_psh(Byte w, Word& s, Word& u)
 {
+	eval_cc();
 	if (btst(w, 7)) do_psh(s, pc);
 	if (btst(w, 6)) do_psh(s, u);
 	if (btst(w, 5)) do_psh(s, y);
@@ -313,6 +300,7 @@ void hd6309::help_psh(Byte w, Word& s, Word& u)
 
 void hd6309::help_pul(Byte w, Word& s, Word& u)
 {
+	eval_cc();
 	if (btst(w, 0)) do_pul(s, cc.all);
 	if (btst(w, 1)) do_pul(s, a);
 	if (btst(w, 2)) do_pul(s, b);
@@ -325,6 +313,7 @@ void hd6309::help_pul(Byte w, Word& s, Word& u)
 
 void hd6309::help_rol(Byte& x)
 {
+	eval_cc();
 	int	oc = cc.bit.c;
 	cc.bit.v = btst(x, 7) ^ btst(x, 6);
 	cc.bit.c = btst(x, 7);
@@ -337,6 +326,7 @@ void hd6309::help_rol(Byte& x)
 
 void hd6309::help_rol(Word& x)
 {
+	eval_cc();
 	int	oc = cc.bit.c;
 	cc.bit.v = btst(x, 15) ^ btst(x, 14);
 	cc.bit.c = btst(x, 15);
@@ -349,6 +339,7 @@ void hd6309::help_rol(Word& x)
 
 void hd6309::help_ror(Byte& x)
 {
+	eval_cc();
 	int	oc = cc.bit.c;
 	cc.bit.c = btst(x, 0);
 	x = x >> 1;
@@ -360,6 +351,7 @@ void hd6309::help_ror(Byte& x)
 
 void hd6309::help_ror(Word& x)
 {
+	eval_cc();
 	int	oc = cc.bit.c;
 	cc.bit.c = btst(x, 0);
 	x = x >> 1;
@@ -371,18 +363,16 @@ void hd6309::help_ror(Word& x)
 
 void hd6309::help_sbc(Byte& x)
 {
-	Byte    m = fetch_operand();
-	int t = x - m - cc.bit.c;
+	Byte	m = fetch_operand();
+	int	t = x - m - flag_c();
 
-	cc.bit.v = btst((Byte)(x ^ m ^ t ^ (t >> 1)), 7);
-	cc.bit.c = btst((Word)t, 8);
-	cc.bit.n = btst((Byte)t, 7);
+	defer_cc(8, false, x, m, t);
 	x = t & 0xff;
-	cc.bit.z = !x;
 }
 
 void hd6309::help_sbc(Word& x)
 {
+	eval_cc();
 	Byte    m = fetch_word_operand();
 	int t = x - m - cc.bit.c;
 
@@ -395,6 +385,7 @@ void hd6309::help_sbc(Word& x)
 
 void hd6309::help_st(Byte x)
 {
+	eval_cc();
 	Word	addr = fetch_effective_address();
 	write(addr, x);
 	cc.bit.v = 0;
@@ -404,6 +395,7 @@ void hd6309::help_st(Byte x)
 
 void hd6309::help_st(Word x)
 {
+	eval_cc();
 	Word	addr = fetch_effective_address();
 	write_word(addr, x);
 	cc.bit.v = 0;
@@ -413,18 +405,16 @@ void hd6309::help_st(Word x)
 
 void hd6309::help_sub(Byte& x)
 {
-	Byte    m = fetch_operand();
-	int t = x - m;
+	Byte	m = fetch_operand();
+	int	t = x - m;
 
-	cc.bit.v = btst((Byte)(x^m^t^(t>>1)),7);
-	cc.bit.c = btst((Word)t,8);
-	cc.bit.n = btst((Byte)t, 7);
+	defer_cc(8, false, x, m, t);
 	x = t & 0xff;
-	cc.bit.z = !x;
 }
 
 void hd6309::help_tst(Byte x)
 {
+	eval_cc();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 7);
 	cc.bit.z = !x;
@@ -433,6 +423,7 @@ void hd6309::help_tst(Byte x)
 
 void hd6309::help_tst(Word x)
 {
+	eval_cc();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 15);
 	cc.bit.z = !x;
@@ -443,131 +434,94 @@ void hd6309::help_tst(Word x)
 
 void hd6309::abx()
 {
-	insn = "ABX";
 	x += b;
 	++cycles;
 }
 
 void hd6309::adca()
 {
-	insn = "ADCA";
 	help_adc(a);
 }
 
 void hd6309::adcb()
 {
-	insn = "ADCB";
 	help_adc(b);
 }
 
 void hd6309::adda()
 {
-	insn = "ADDA";
 	help_add(a);
 }
 
 void hd6309::addb()
 {
-	insn = "ADDB";
 	help_add(b);
 }
 
 void hd6309::adde()
 {
-	insn = ":ADDE";
 	help_add(e);
 }
 
 void hd6309::addf()
 {
-	insn = ":ADDF";
 	help_add(f);
 }
 
 void hd6309::addd()
 {
-	insn = "ADDD";
 	Word	m = fetch_word_operand();
+	int	t = d + m;
 
-	{
-		Word	t = (d & 0x7fff) + (m & 0x7fff);
-		cc.bit.v = btst(t, 15);
-	}
-
-	{
-		DWord	t = (DWord)d + m;
-		cc.bit.c = btst(t, 16);
-		d = (Word)(t & 0xffff);
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(d, 15);
-	cc.bit.z = !d;
+	defer_cc(16, false, d, m, t);
+	d = t & 0xffff;
 	++cycles;
 }
 
 void hd6309::addw()
 {
-	insn = ":ADDW";
 	Word	m = fetch_word_operand();
+	int	t = w + m;
 
-	{
-		Word	t = (w & 0x7fff) + (m & 0x7fff);
-		cc.bit.v = btst(t, 15);
-	}
-
-	{
-		DWord	t = (DWord)w + m;
-		cc.bit.c = btst(t, 16);
-		w = (Word)(t & 0xffff);
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(w, 15);
-	cc.bit.z = !w;
+	defer_cc(16, false, w, m, t);
+	w = t & 0xffff;
 	++cycles;
 }
 
 void hd6309::anda()
 {
-	insn = "ANDA";
 	help_and(a);
 }
 
 void hd6309::andb()
 {
-	insn = "ANDB";
 	help_and(b);
 }
 
 void hd6309::andd()
 {
-	insn = ":ANDD";
 	help_and(d);
 }
 
 void hd6309::andcc()
 {
-	insn = "ANDCC";
+	eval_cc();
 	cc.all &= fetch_operand();
 	++cycles;
 }
 
 void hd6309::asra()
 {
-	insn = "ASRA";
 	help_asr(a);
 }
 
 void hd6309::asrb()
 {
-	insn = "ASRB";
 	help_asr(b);
 }
 
 void hd6309::asr()
 {
-	insn = "ASR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 
@@ -577,96 +531,82 @@ void hd6309::asr()
 
 void hd6309::bcc()
 {
-	insn = "BCC";
-	do_br("cc", !cc.bit.c);
+	do_br("cc", !flag_c());
 }
 
 void hd6309::lbcc()
 {
-	insn = "LBCC";
-	do_lbr("cc", !cc.bit.c);
+	do_lbr("cc", !flag_c());
 }
 
 void hd6309::bcs()
 {
-	insn = "BCS";
-	do_br("cs", cc.bit.c);
+	do_br("cs", flag_c());
 }
 
 void hd6309::lbcs()
 {
-	insn = "LBCS";
-	do_lbr("cs", cc.bit.c);
+	do_lbr("cs", flag_c());
 }
 
 void hd6309::beq()
 {
-	insn = "BEQ";
-	do_br("eq", cc.bit.z);
+	do_br("eq", flag_z());
 }
 
 void hd6309::lbeq()
 {
-	insn = "LBEQ";
-	do_lbr("eq", cc.bit.z);
+	do_lbr("eq", flag_z());
 }
 
 void hd6309::bge()
 {
-	insn = "BGE";
-	do_br("ge", !(cc.bit.n ^ cc.bit.v));
+	do_br("ge", !(flag_n() ^ flag_v()));
 }
 
 void hd6309::lbge()
 {
-	insn = "LGBE";
-	do_lbr("ge", !(cc.bit.n ^ cc.bit.v));
+	do_lbr("ge", !(flag_n() ^ flag_v()));
 }
 
 void hd6309::bgt()
 {
-	insn = "BGT";
-	do_br("gt", !(cc.bit.z | (cc.bit.n ^ cc.bit.v)));
+	do_br("gt", !(flag_z() | (flag_n() ^ flag_v())));
 }
 
 void hd6309::lbgt()
 {
-	insn = "LBGT";
-	do_lbr("gt", !(cc.bit.z | (cc.bit.n ^ cc.bit.v)));
+	do_lbr("gt", !(flag_z() | (flag_n() ^ flag_v())));
 }
 
 void hd6309::bhi()
 {
-	insn = "BHI";
-	do_br("hi", !(cc.bit.c | cc.bit.z));
+	do_br("hi", !(flag_c() | flag_z()));
 }
 
 void hd6309::lbhi()
 {
-	insn = "LBHI";
-	do_lbr("hi", !(cc.bit.c | cc.bit.z));
+	do_lbr("hi", !(flag_c() | flag_z()));
 }
 
 void hd6309::bita()
 {
-	insn = "BITA";
 	help_bit(a);
 }
 
 void hd6309::bitb()
 {
-	insn = "BITB";
 	help_bit(b);
 }
 
 void hd6309::bitd()
 {
-	insn = ":BITD";
 	help_bit(d);
 }
 
 void hd6309::bitmd()
 {
+	eval_cc();
 	Byte imm = fetch_operand() & 0xc0; // Only interested in the top two bits
 
     cc.bit.z = !(md.all & imm);
@@ -674,181 +614,154 @@ void hd6309::bitmd()
 
 void hd6309::ble()
 {
-	insn = "BLE";
-	do_br("le", cc.bit.z | (cc.bit.n ^ cc.bit.v));
+	do_br("le", flag_z() | (flag_n() ^ flag_v()));
 }
 
 void hd6309::lble()
 {
-	insn = "LBLE";
-	do_lbr("le", cc.bit.z | (cc.bit.n ^ cc.bit.v));
+	do_lbr("le", flag_z() | (flag_n() ^ flag_v()));
 }
 
 void hd6309::bls()
 {
-	insn = "BLS";
-	do_br("ls", cc.bit.c | cc.bit.z);
+	do_br("ls", flag_c() | flag_z());
 }
 
 void hd6309::lbls()
 {
-	insn = "LBLS";
-	do_lbr("ls", cc.bit.c | cc.bit.z);
+	do_lbr("ls", flag_c() | flag_z());
 }
 
 void hd6309::blt()
 {
-	insn = "BLT";
-	do_br("lt", cc.bit.n ^ cc.bit.v);
+	do_br("lt", flag_n() ^ flag_v());
 }
 
 void hd6309::lblt()
 {
-	insn = "LBLT";
-	do_lbr("lt", cc.bit.n ^ cc.bit.v);
+	do_lbr("lt", flag_n() ^ flag_v());
 }
 
 void hd6309::bmi()
 {
-	insn = "BMI";
-	do_br("mi", cc.bit.n);
+	do_br("mi", flag_n());
 }
 
 void hd6309::lbmi()
 {
-	insn = "LBMI";
-	do_lbr("mi", cc.bit.n);
+	do_lbr("mi", flag_n());
 }
 
 void hd6309::bne()
 {
-	insn = "BNE";
-	do_br("ne", !cc.bit.z);
+	do_br("ne", !flag_z());
 }
 
 void hd6309::lbne()
 {
-	insn = "LBNE";
-	do_lbr("ne", !cc.bit.z);
+	do_lbr("ne", !flag_z());
 }
 
 void hd6309::bpl()
 {
-	insn = "BPL";
-	do_br("pl", !cc.bit.n);
+	do_br("pl", !flag_n());
 }
 
 void hd6309::lbpl()
 {
-	insn = "LBPL";
-	do_lbr("pl", !cc.bit.n);
+	do_lbr("pl", !flag_n());
 }
 
 void hd6309::bra()
 {
-	insn = "BRA";
 	do_br("ra", 1);
 }
 
 void hd6309::lbra()
 {
-	insn = "LBRA";
 	do_lbr("ra", 1);
 }
 
 void hd6309::brn()
 {
-	insn = "BRN";
 	do_br("rn", 0);
 }
 
 void hd6309::lbrn()
 {
-	insn = "LBRN";
 	do_lbr("rn", 0);
 }
 
 void hd6309::bsr()
 {
-	insn = "BSR";
 	Byte	x = fetch_operand();
 	do_psh(s, pc);
 	pc += extend8(x);
 	cycles += 3;
+	profile_call(s);
 }
 
 void hd6309::lbsr()
 {
-	insn = "LBSR";
 	Word	x = fetch_word_operand();
 	do_psh(s, pc);
 	pc += x;
 	cycles += 4;
+	profile_call(s);
 }
 
 void hd6309::bvc()
 {
-	insn = "BVC";
-	do_br("vc", !cc.bit.v);
+	do_br("vc", !flag_v());
 }
 
 void hd6309::lbvc()
 {
-	insn = "LBVC";
-	do_lbr("vc", !cc.bit.v);
+	do_lbr("vc", !flag_v());
 }
 
 void hd6309::bvs()
 {
-	insn = "BVS";
-	do_br("vs", cc.bit.v);
+	do_br("vs", flag_v());
 }
 
 void hd6309::lbvs()
 {
-	insn = "LBVS";
-	do_lbr("vs", cc.bit.v);
+	do_lbr("vs", flag_v());
 }
 
 void hd6309::clra()
 {
-	insn = "CLRA";
 	help_clr(a);
 }
 
 void hd6309::clrb()
 {
-	insn = "CLRB";
 	help_clr(b);
 }
 
 void hd6309::clre()
 {
-	insn = ":CLRE";
 	help_clr(e);
 }
 
 void hd6309::clrf()
 {
-	insn = ":CLRF";
 	help_clr(f);
 }
 
 void hd6309::clrd()
 {
-	insn = ":CLRD";
 	help_clr(d);
 }
 
 void hd6309::clrw()
 {
-	insn = ":CLRW";
 	help_clr(w);
 }
 
 void hd6309::clr()
 {
-	insn = "CLR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_clr(m);
@@ -857,67 +770,57 @@ void hd6309::clr()
 
 void hd6309::cmpa()
 {
-	insn = "CMPA";
 	help_cmp(a);
 }
 
 void hd6309::cmpb()
 {
-	insn = "CMPB";
 	help_cmp(b);
 }
 
 void hd6309::cmpe()
 {
-	insn = ":CMPE";
 	help_cmp(e);
 }
 
 void hd6309::cmpf()
 {
-	insn = ":CMPF";
 	help_cmp(f);
 }
 
 void hd6309::cmpd()
 {
-	insn = "CMPD";
 	help_cmp(d);
 }
 
 void hd6309::cmpw()
 {
-	insn = "CMPW";
 	help_cmp(w);
 }
 
 void hd6309::cmpx()
 {
-	insn = "CMPX";
 	help_cmp(x);
 }
 
 void hd6309::cmpy()
 {
-	insn = "CMPY";
 	help_cmp(y);
 }
 
 void hd6309::cmpu()
 {
-	insn = "CMPU";
 	help_cmp(u);
 }
 
 void hd6309::cmps()
 {
-	insn = "CMPS";
 	help_cmp(s);
 }
 
 void hd6309::cwai()
 {
-	insn = "CWAI";
+	eval_cc();
 	Byte	n = fetch_operand();
 	cc.all &= n;
 	cc.bit.e = 1;
@@ -928,43 +831,36 @@ void hd6309::cwai()
 
 void hd6309::coma()
 {
-	insn = "COMA";
 	help_com(a);
 }
 
 void hd6309::comb()
 {
-	insn = "COMB";
 	help_com(b);
 }
 
 void hd6309::come()
 {
-	insn = ":COME";
 	help_com(e);
 }
 
 void hd6309::comf()
 {
-	insn = ":COMF";
 	help_com(f);
 }
 
 void hd6309::comd()
 {
-	insn = ":COMD";
 	help_com(d);
 }
 
 void hd6309::comw()
 {
-	insn = ":COMW";
 	help_com(w);
 }
 
 void hd6309::com()
 {
-	insn = "COM";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_com(m);
@@ -973,7 +869,7 @@ void hd6309::com()
 
 void hd6309::daa()
 {
-	insn = "DAA";
+	eval_cc();
 	Byte	c = 0;
 	Byte	lsn = (a & 0x0f);
 	Byte	msn = (a & 0xf0) >> 4;
@@ -1001,43 +897,36 @@ void hd6309::daa()
 
 void hd6309::deca()
 {
-	insn = "DECA";
 	help_dec(a);
 }
 
 void hd6309::decb()
 {
-	insn = "DECB";
 	help_dec(b);
 }
 
 void hd6309::dece()
 {
-	insn = ":DECE";
 	help_dec(e);
 }
 
 void hd6309::decf()
 {
-	insn = ":DECF";
 	help_dec(f);
 }
 
 void hd6309::decd()
 {
-	insn = ":DECD";
 	help_dec(d);
 }
 
 void hd6309::decw()
 {
-	insn = ":DECW";
 	help_dec(w);
 }
 
 void hd6309::dec()
 {
-	insn = "DEC";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_dec(m);
@@ -1046,25 +935,21 @@ void hd6309::dec()
 
 void hd6309::eora()
 {
-	insn = "EORA";
 	help_eor(a);
 }
 
 void hd6309::eorb()
 {
-	insn = "EORB";
 	help_eor(b);
 }
 
 void hd6309::eord()
 {
-	insn = ":EORD";
 	help_eor(d);
 }
 
 void hd6309::exg()
 {
-	insn = "EXG";
 	Byte w = fetch_operand();
 	int r1 = (w & 0xf0) >> 4;
 	int r2 = (w & 0x0f) >> 0;
@@ -1082,43 +967,36 @@ void hd6309::exg()
 
 void hd6309::inca()
 {
-	insn = "INCA";
 	help_inc(a);
 }
 
 void hd6309::incb()
 {
-	insn = "INCB";
 	help_inc(b);
 }
 
 void hd6309::ince()
 {
-	insn = ":INCE";
 	help_inc(e);
 }
 
 void hd6309::incf()
 {
-	insn = ":INCF";
 	help_inc(f);
 }
 
 void hd6309::incd()
 {
-	insn = ":INCD";
 	help_inc(d);
 }
 
 void hd6309::incw()
 {
-	insn = ":INCW";
 	help_inc(w);
 }
 
 void hd6309::inc()
 {
-	insn = "INC";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_inc(m);
@@ -1127,76 +1005,65 @@ void hd6309::inc()
 
 void hd6309::jmp()
 {
-	insn = "JMP";
 	pc = fetch_effective_address();
 }
 
 void hd6309::jsr()
 {
-	insn = "JSR";
 	Word	addr = fetch_effective_address();
 	do_psh(s, pc);
 	pc = addr;
 	cycles += 2;
+	profile_call(s);
 }
 
 void hd6309::lda()
 {
-	insn = "LDA";
 	help_ld(a);
 }
 
 void hd6309::ldb()
 {
-	insn = "LDB";
 	help_ld(b);
 }
 
 void hd6309::lde()
 {
-	insn = ":LDE";
 	help_ld(e);
 }
 
 void hd6309::ldf()
 {
-	insn = ":LDF";
 	help_ld(f);
 }
 
 void hd6309::ldd()
 {
-	insn = "LDD";
 	help_ld(d);
 }
 
 void hd6309::ldw()
 {
-	insn = ":LDW";
 	help_ld(w);
 }
 
 void hd6309::ldx()
 {
-	insn = "LDX";
 	help_ld(x);
 }
 
 void hd6309::ldy()
 {
-	insn = "LDY";
 	help_ld(y);
 }
 
 void hd6309::lds()
 {
-	insn = "LDS";
 	help_ld(s);
 }
 
 void hd6309::ldu()
 {
-	insn = "LDU";
 	help_ld(u);
 }
 
@@ -1209,7 +1076,7 @@ void hd6309::ldmd()
 
 void hd6309::leax()
 {
-	insn = "LEAX";
+	eval_cc();
 	x = fetch_effective_address();
 	cc.bit.z = !x;
 	++cycles;
@@ -1217,7 +1084,7 @@ void hd6309::leax()
 
 void hd6309::leay()
 {
-	insn = "LEAY";
+	eval_cc();
 	y = fetch_effective_address();
 	cc.bit.z = !y;
 	++cycles;
@@ -1225,39 +1092,33 @@ void hd6309::leay()
 
 void hd6309::leas()
 {
-	insn = "LEAS";
 	s = fetch_effective_address();
 	++cycles;
 }
 
 void hd6309::leau()
 {
-	insn = "LEAU";
 	u = fetch_effective_address();
 	++cycles;
 }
 
 void hd6309::lsla()
 {
-	insn = "LSLA";
 	help_lsl(a);
 }
 
 void hd6309::lslb()
 {
-	insn = "LSLB";
 	help_lsl(b);
 }
 
 void hd6309::lsld()
 {
-	insn = ":LSLD";
 	help_lsl(d);
 }
 
 void hd6309::lsl()
 {
-	insn = "LSL";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_lsl(m);
@@ -1266,31 +1127,26 @@ void hd6309::lsl()
 
 void hd6309::lsra()
 {
-	insn = "LSRA";
 	help_lsr(a);
 }
 
 void hd6309::lsrb()
 {
-	insn = "LSRB";
 	help_lsr(b);
 }
 
 void hd6309::lsrd()
 {
-	insn = ":LSRD";
 	help_lsr(d);
 }
 
 void hd6309::lsrw()
 {
-	insn = ":LSRW";
 	help_lsr(w);
 }
 
 void hd6309::lsr()
 {
-	insn = "LSR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_lsr(m);
@@ -1299,7 +1155,7 @@ void hd6309::lsr()
 
 void hd6309::mul()
 {
-	insn = "MUL";
+	eval_cc();
 	d = a * b;
 	cc.bit.c = btst(b, 7);
 	cc.bit.z = !d;
@@ -1308,19 +1164,16 @@ void hd6309::mul()
 
 void hd6309::nega()
 {
-	insn = "NEGA";
 	help_neg(a);
 }
 
 void hd6309::negb()
 {
-	insn = "NEGB";
 	help_neg(b);
 }
 
 void hd6309::neg()
 {
-	insn = "NEG";
 	Word 	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_neg(m);
@@ -1329,38 +1182,33 @@ void hd6309::neg()
 
 void hd6309::nop()
 {
-	insn = "NOP";
 	++cycles;
 }
 
 void hd6309::ora()
 {
-	insn = "ORA";
 	help_or(a);
 }
 
 void hd6309::orb()
 {
-	insn = "ORB";
 	help_or(b);
 }
 
 void hd6309::ord()
 {
-	insn = ":ORD";
 	help_or(d);
 }
 
 void hd6309::orcc()
 {
-	insn = "ORCC";
+	eval_cc();
 	cc.all |= fetch_operand();
 	++cycles;
 }
 
 void hd6309::pshs()
 {
-	insn = "PSHS";
 	Byte w = fetch_operand();
 	help_psh(w, s, u);
 	cycles += 3;
@@ -1368,7 +1216,6 @@ void hd6309::pshs()
 
 void hd6309::pshu()
 {
-	insn = "PSHU";
 	Byte w = fetch_operand();
 	help_psh(w, u, s);
 	cycles += 3;
@@ -1376,7 +1223,6 @@ void hd6309::pshu()
 
 void hd6309::puls()
 {
-	insn = "PULS";
 	Byte w = fetch_operand();
 	help_pul(w, s, u);
 	cycles += 3;
@@ -1384,7 +1230,6 @@ void hd6309::puls()
 
 void hd6309::pulu()
 {
-	insn = "PULU";
 	Byte w = fetch_operand();
 	help_pul(w, u, s);
 	cycles += 3;
@@ -1392,31 +1237,26 @@ void hd6309::pulu()
 
 void hd6309::rola()
 {
-	insn = "ROLA";
 	help_rol(a);
 }
 
 void hd6309::rolb()
 {
-	insn = "ROLB";
 	help_rol(b);
 }
 
 void hd6309::rold()
 {
-	insn = ":ROLD";
 	help_rol(d);
 }
 
 void hd6309::rolw()
 {
-	insn = ":ROLD";
 	help_rol(d);
 }
 
 void hd6309::rol()
 {
-	insn = "ROL";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_rol(m);
@@ -1425,31 +1265,26 @@ void hd6309::rol()
 
 void hd6309::rora()
 {
-	insn = "RORA";
 	help_ror(a);
 }
 
 void hd6309::rorb()
 {
-	insn = "RORB";
 	help_ror(b);
 }
 
 void hd6309::rord()
 {
-	insn = ":RORD";
 	help_ror(d);
 }
 
 void hd6309::rorw()
 {
-	insn = ":RORW";
 	help_ror(w);
 }
 
 void hd6309::ror()
 {
-	insn = "ROR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_ror(m);
@@ -1458,7 +1293,6 @@ void hd6309::ror()
 
 void hd6309::rti()
 {
-	insn = "RTI";
 	help_pul(0x01, s, u);
 	if (cc.bit.e) {
 		help_pul(0xfe, s, u);
@@ -1466,36 +1300,34 @@ void hd6309::rti()
 		help_pul(0x80, s, u);
 	}
 	cycles += 2;
+	profile_return(s);
 }
 
 void hd6309::rts()
 {
-	insn = "RTS";
 	do_pul(s, pc);
 	cycles += 2;
+	profile_return(s);
 }
 
 void hd6309::sbca()
 {
-	insn = "SBCA";
 	help_sbc(a);
 }
 
 void hd6309::sbcb()
 {
-	insn = "SBCB";
 	help_sbc(b);
 }
 
 void hd6309::sbcd()
 {
-	insn = ":SBCD";
 	help_sbc(d);
 }
 
 void hd6309::sex()
 {
-	insn = "SEX";
+	eval_cc();
 	cc.bit.n = btst(b, 7);
 	cc.bit.z = !b;
 	a = cc.bit.n ? 255 : 0;
@@ -1504,104 +1336,86 @@ void hd6309::sex()
 
 void hd6309::sta()
 {
-	insn = "STA";
 	help_st(a);
 }
 
 void hd6309::stb()
 {
-	insn = "STB";
 	help_st(b);
 }
 
 void hd6309::ste()
 {
-	insn = ":STE";
 	help_st(e);
 }
 
 void hd6309::stf()
 {
-	insn = ":STF";
 	help_st(f);
 }
 
 void hd6309::std()
 {
-	insn = "STD";
 	help_st(d);
 }
 
 void hd6309::stw()
 {
-	insn = ":STW";
 	help_st(w);
 }
 
 void hd6309::stx()
 {
-	insn = "STX";
 	help_st(x);
 }
 
 void hd6309::sty()
 {
-	insn = "STY";
 	help_st(y);
 }
 
 void hd6309::sts()
 {
-	insn = "STS";
 	help_st(s);
 }
 
 void hd6309::stu()
 {
-	insn = "STU";
 	help_st(u);
 }
 
 void hd6309::suba()
 {
-	insn = "SUBA";
 	help_sub(a);
 }
 
 void hd6309::subb()
 {
-	insn = "SUBB";
 	help_sub(b);
 }
 
 void hd6309::sube()
 {
-	insn = ":SUBE";
 	help_sub(e);
 }
 
 void hd6309::subf()
 {
-	insn = "SUBF";
 	help_sub(f);
 }
 
 void hd6309::subd()
 {
-	insn = "SUBD";
-	Word    m = fetch_word_operand();
-	int t = d - m;
+	Word	m = fetch_word_operand();
+	int	t = d - m;
 
-	cc.bit.v = btst((DWord)(d ^ m ^ t ^(t >> 1)), 15);
-	cc.bit.c = btst((DWord)t, 16);
-	cc.bit.n = btst((DWord)t, 15);
+	defer_cc(16, false, d, m, t);
 	d = t & 0xffff;
-	cc.bit.z = !d;
 }
 
 void hd6309::subw()
 {
-	insn = ":SUBW";
+	eval_cc();
 	Word    m = fetch_word_operand();
 	int t = d - m;
 
@@ -1614,42 +1428,40 @@ void hd6309::subw()
 
 void hd6309::swi()
 {
-	insn = "SWI";
 	cc.bit.e = 1;
 	help_psh(0xff, s, u);
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfffa);
 	cycles += 4;
+	profile_call(s);
 }
 
 void hd6309::swi2()
 {
-	insn = "SWI2";
 	cc.bit.e = 1;
 	help_psh(0xff, s, u);
 	pc = read_word(0xfff4);
 	cycles += 4;
+	profile_call(s);
 }
 
 void hd6309::swi3()
 {
-	insn = "SWI3";
 	cc.bit.e = 1;
 	help_psh(0xff, s, u);
 	pc = read_word(0xfff2);
 	cycles += 4;
+	profile_call(s);
 }
 
 void hd6309::sync()
 {
-	insn = "SYNC";
 	waiting_sync = true;
 	++cycles;
 }
 
 void hd6309::tfr()
 {
-	insn = "TFR";
 	Byte	w = fetch_operand();
 	int r1 = (w & 0xf0) >> 4;
 	int r2 = (w & 0x0f) >> 0;
@@ -1667,43 +1479,36 @@ void hd6309::tfr()
 
 void hd6309::tsta()
 {
-	insn = "TSTA";
 	help_tst(a);
 }
 
 void hd6309::tstb()
 {
-	insn = "TSTB";
 	help_tst(b);
 }
 
 void hd6309::tste()
 {
-	insn = ":TSTE";
 	help_tst(e);
 }
 
 void hd6309::tstf()
 {
-	insn = ":TSTF";
 	help_tst(f);
 }
 
 void hd6309::tstd()
 {
-	insn = ":TSTD";
 	help_tst(d);
 }
 
 void hd6309::tstw()
 {
-	insn = ":TSTW";
 	help_tst(w);
 }
 
 void hd6309::tst()
 {
-	insn = "TST";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_tst(m);
@@ -1,37 +1,233 @@
 //
 //	main.cpp
 //
+//	usim [-s] [-r MHz] [-a Hz | -T] [-L cycles] [-i input] [-o output] [-c cycles] [-p pc] [-m text] [-I cycles] <hexfile>
+//
+//	With -r the guest is held to real time at that clock rate, rather
+//	than running as fast as the host can manage, and how closely it
+//	kept to it is reported at the end.
+//
+//	The ACIA normally moves a character each way every 1000 cycles.
+//	With -a it's clocked at that rate instead, e.g. 153600 for 9600
+//	baud with the usual divide by 16, against a CPU running at the
+//	-r rate or else 1MHz; with -T characters take no time at all.
+//
+//	A file inserted with ~< is read as fast as the guest takes it,
+//	waiting -L cycles after each line for interpreters that need to
+//	digest it.
+//
+//	The terminal's I/O is done by a thread of its own, except with -s,
+//	which has the CPU poll it directly as it always used to.
+//
+//	With -i or -o there's no terminal: the input file is typed in
+//	only as fast as the guest reads it, and everything the guest
+//	writes goes to the output file (or stdout).  The run stops after
+//	the cycle budget, before the instruction at the (hex) PC, once
+//	the output contains the text, or once the input has all been
+//	read and the guest has neither read nor written anything for the
+//	-I cycles, whichever comes first.  The exit status says which:
+//
+//		0	the PC or text was reached, or the terminal was closed
+//		1	an invalid instruction, or a usage or file error
+//		2	the cycle budget ran out
+//		3	the guest went idle
+//
 
 #include <cstdlib>
 #include <cstdio>
 #include <csignal>
+#include <memory>
+#include <string>
 #include <unistd.h>
 
 #include "hd6309.h"
 #include "mc6850.h"
 #include "dkc.h"
 #include "term.h"
+#include "evterm.h"
+#include "script.h"
+#include "pacer.h"
+#include "trace.h"
 #include "memory.h"
 
+enum {
+	exit_stopped = EXIT_SUCCESS,
+	exit_failed = EXIT_FAILURE,
+	exit_budget = 2,
+	exit_idle = 3
+};
+
+/*
+ * the terminal when there's no user, writing to a host file and
+ * watching the output for some text
+ */
+class Headless : public Script {
+
+protected:
+	USim&				sys;
+	FILE*				capture;
+	std::string			pattern;
+	std::string			recent;		// the tail of the output
+	bool				matched = false;
+	Cycles				active = 0;	// when last read or written
+
+public:
+	virtual void		write(Byte);
+	virtual Byte		read();
+
+public:
+	bool				has_matched() const { return matched; };
+
+	// all the input has gone and nothing has happened for `n` cycles
+	bool				idle_for(Cycles n) const {
+							return input_pos == input.size() && sys.cycle_count() - active >= n;
+						};
+
+// Public constructor
+public:
+						Headless(USim& sys, FILE* capture, const std::string& pattern)
+							: sys(sys), capture(capture), pattern(pattern) {};
+
+};
+
+Byte Headless::read()
+{
+	active = sys.cycle_count();
+	return Script::read();
+}
+
+// Only the output since the text could last have started is kept,
+// so a match halts the CPU as soon as its final byte is written
+void Headless::write(Byte ch)
+{
+	active = sys.cycle_count();
+	fputc(ch, capture);
+
+	if (pattern.empty() || matched) {
+		return;
+	}
+
+	recent.push_back(ch);
+	if (recent.size() >= pattern.size() &&
+	    recent.compare(recent.size() - pattern.size(), pattern.size(), pattern) == 0)
+	{
+		matched = true;
+		sys.halt();
+	}
+	if (recent.size() > 2 * pattern.size()) {
+		recent.erase(0, recent.size() - pattern.size());
+	}
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: usim [-s] [-r MHz] [-a Hz | -T] [-L cycles] [-i input] [-o output] [-c cycles] [-p pc] [-m text] [-I cycles] <hexfile>\n");
+	exit(exit_failed);
+}
+
 int main(int argc, char *argv[])
 {
-	if (argc != 2) {
-		fprintf(stderr, "usage: usim <hexfile>\n");
-		return EXIT_FAILURE;
+	const char *input_file = nullptr;
+	const char *output_file = nullptr;
+	Cycles budget = 0;
+	long stop_pc = -1;
+	std::string pattern;
+	Cycles idle = 0;
+	double mhz = 0;
+	bool polled = false;
+	double acia_hz = 0;
+	bool turbo = false;
+	Cycles line_delay = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "sr:a:TL:i:o:c:p:m:I:")) != -1) {
+		switch (opt) {
+			case 's':
+				polled = true;
+				break;
+			case 'r':
+				mhz = strtod(optarg, NULL);
+				break;
+			case 'a':
+				acia_hz = strtod(optarg, NULL);
+				break;
+			case 'T':
+				turbo = true;
+				break;
+			case 'L':
+				line_delay = strtoull(optarg, NULL, 0);
+				break;
+			case 'i':
+				input_file = optarg;
+				break;
+			case 'o':
+				output_file = optarg;
+				break;
+			case 'c':
+				budget = strtoull(optarg, NULL, 0);
+				break;
+			case 'p':
+				stop_pc = strtoul(optarg, NULL, 16);
+				break;
+			case 'm':
+				pattern = optarg;
+				break;
+			case 'I':
+				idle = strtoull(optarg, NULL, 0);
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc - 1 || stop_pc > 0xffff || mhz < 0 || acia_hz < 0 || (acia_hz && turbo)) {
+		usage();
 	}
 
-	(void)signal(SIGINT, SIG_IGN);
+	bool headless = input_file || output_file;
+	if (!headless && (!pattern.empty() || idle)) {
+		fprintf(stderr, "usim: -m and -I need -i or -o\n");
+		usage();
+	}
 
 	const Word ram_size = 0x8000;
 	const Word rom_base = 0xc000;
 	const Word rom_size = 0x10000 - rom_base;
 
 	hd6309			cpu;
-	Terminal 		term(cpu);
+	std::unique_ptr<Terminal>	term;
+	std::unique_ptr<Headless>	script;
+	FILE			*capture = stdout;
+	bool			failed = false;
+
+	if (headless) {
+		if (output_file && !(capture = fopen(output_file, "w"))) {
+			perror(output_file);
+			return exit_failed;
+		}
+		script.reset(new Headless(cpu, capture, pattern));
+		if (input_file && !script->load(input_file)) {
+			perror(input_file);
+			return exit_failed;
+		}
+
+		// an invalid instruction just ends the run
+		cpu.abort = [&]() {
+			failed = true;
+			cpu.halt();
+		};
+	} else {
+		(void)signal(SIGINT, SIG_IGN);
+		if (polled) {
+			term.reset(new Terminal(cpu));
+		} else {
+			term.reset(new EventTerminal(cpu));
+		}
+		term->set_line_delay(line_delay);
+	}
 
 	auto ram = std::make_shared<RAM>(ram_size);
 	auto rom = std::make_shared<ROM>(rom_size);
-	auto acia = std::make_shared<mc6850>(term);
+	auto acia = headless ? std::make_shared<mc6850>(*script) : std::make_shared<mc6850>(*term);
 	auto disks = std::make_shared<dkc>();
 
 	cpu.attach(ram, 0x0000, ~(ram_size - 1));
@@ -39,14 +235,149 @@ int main(int argc, char *argv[])
 	cpu.attach(acia, 0xa000, 0xfffe);
 	cpu.attach(disks, 0xa008, 0xfff8);
 
-	cpu.FIRQ.bind([&]() {
-		return acia->IRQ;
-	});
+	acia->IRQ_line.connect(cpu.FIRQ_line);
+
+	if (turbo) {
+		acia->set_turbo();
+	} else if (acia_hz) {
+		acia->set_baud_clock(mhz ? mhz * 1e6 : 1e6, acia_hz);
+	}
+
+	std::shared_ptr<Pacer> pacer;
+	if (mhz) {
+		pacer = std::make_shared<Pacer>(mhz * 1e6);
+		cpu.attach(pacer);
+	}
 
-	rom->load(argv[1], rom_base);
+	rom->load(argv[optind], rom_base);
+
+	// binary tracing to $USIM_TRACE, either of every instruction as
+	// it runs, or of just the last $USIM_TRACE_LAST when it stops
+	const char *trace_file = getenv("USIM_TRACE");
+	const char *trace_last = getenv("USIM_TRACE_LAST");
+	std::shared_ptr<Trace> trace;
+
+	if (trace_file) {
+		size_t n = trace_last ? strtoul(trace_last, NULL, 0) : 0x10000;
+		trace = std::make_shared<Trace>(n, "6309");
+		if (trace_last) {
+			// dumped when the run ends, except that abort()
+			// doesn't return when interactive, so before it
+			if (!headless) {
+				auto abort = cpu.abort;
+				cpu.abort = [&, abort]() {
+					trace->dump(trace_file);
+					abort();
+				};
+			}
+		} else if (!trace->stream(trace_file)) {
+			perror(trace_file);
+			return exit_failed;
+		}
+		cpu.trace_to(trace);
+	}
+
+	// profiling of where guest time goes, written when it stops: the
+	// hottest addresses to $USIM_PROFILE, and the call stacks to
+	// $USIM_CALLGRAPH in the collapsed form used for flame graphs,
+	// each routine's totals also going into the profile; symbols are
+	// from the asm6809 listings named in $USIM_SYMBOLS, colon separated
+	const char *profile_file = getenv("USIM_PROFILE");
+	const char *callgraph_file = getenv("USIM_CALLGRAPH");
+	const char *listings = getenv("USIM_SYMBOLS");
+	std::shared_ptr<Profile> profile;
+	std::shared_ptr<CallGraph> callgraph;
+	Symbols symbols;
+
+	if (profile_file || callgraph_file) {
+#ifndef PROFILE
+		fprintf(stderr, "usim: built without -DPROFILE, so the profile will be empty\n");
+#endif
+		if (profile_file) {
+			profile = std::make_shared<Profile>();
+			cpu.profile_to(profile);
+		}
+		if (callgraph_file) {
+			callgraph = std::make_shared<CallGraph>();
+			cpu.call_graph_to(callgraph);
+		}
+
+		std::string list = listings ? listings : "";
+		for (size_t i = 0, j; i < list.size(); i = j + 1) {
+			j = list.find(':', i);
+			if (j == std::string::npos) {
+				j = list.size();
+			}
+			std::string listing = list.substr(i, j - i);
+			if (!listing.empty() && !symbols.load_listing(listing.c_str())) {
+				fprintf(stderr, "usim: can't read symbols from %s\n", listing.c_str());
+			}
+		}
+	}
 
 	cpu.reset();
-	cpu.run();
 
-	return EXIT_SUCCESS;
+	// the PC and idle checks are made before every instruction,
+	// so only pay for them when they're wanted
+	Cycles limit = budget ? budget : UINT64_MAX;
+	if (stop_pc >= 0 || idle) {
+		cpu.run_until([&]() {
+			return cpu.cycle_count() >= limit || cpu.get_pc() == stop_pc ||
+				(idle && script->idle_for(idle));
+		});
+	} else if (budget) {
+		cpu.run_for(budget);
+	} else {
+		cpu.run();
+	}
+
+	int status = exit_stopped;
+	if (failed) {
+		status = exit_failed;
+	} else if ((script && script->has_matched()) || cpu.get_pc() == stop_pc) {
+		status = exit_stopped;
+	} else if (idle && script->idle_for(idle)) {
+		status = exit_idle;
+	} else if (budget && cpu.cycle_count() >= budget) {
+		status = exit_budget;
+	}
+
+	if (capture != stdout) {
+		fclose(capture);
+	}
+
+	if (pacer) {
+		pacer->report(stderr);
+	}
+
+	if (trace && trace_last) {
+		trace->dump(trace_file);
+	}
+
+	if (callgraph) {
+		callgraph->stop(cpu.cycle_count());
+
+		FILE *fp = fopen(callgraph_file, "w");
+		if (!fp) {
+			perror(callgraph_file);
+			return exit_failed;
+		}
+		callgraph->collapsed(fp, symbols);
+		fclose(fp);
+	}
+
+	if (profile) {
+		FILE *fp = fopen(profile_file, "w");
+		if (!fp) {
+			perror(profile_file);
+			return exit_failed;
+		}
+		profile->report(fp, symbols, cpu.cycle_count());
+		if (callgraph) {
+			callgraph->report(fp, symbols);
+		}
+		fclose(fp);
+	}
+
+	return status;
 }
@@ -6,10 +6,12 @@
 //
 
 #include "mc6809.h"
+#include "trace.h"
 #include <memory>
+#include <vector>
 #include <cstdio>
 
-mc6809::mc6809() : a(acc.byte.a), b(acc.byte.b), d(acc.d)
+mc6809::mc6809() : a(acc.byte.a), b(acc.byte.b), d(acc.d), opcodes(opcode_table()), disasm(Disassembler::mc6809_set)
 {
 }
 
@@ -19,6 +21,7 @@ mc6809::~mc6809()
 
 void mc6809::reset()
 {
+	eval_cc();
 	USim::reset();
 
 	pc = read_word(0xfffe);
@@ -35,15 +38,103 @@ void mc6809::reset()
 	nmi_previous = true;	/* no NMI present */
 }
 
+void mc6809::save_state(StateBuffer& state)
+{
+	USim::save_state(state);
+
+	eval_cc();
+	state.put(cc.all);
+	state.put(dp);
+	state.put(d);
+	state.put(x);
+	state.put(y);
+	state.put(u);
+	state.put(s);
+	state.put(waiting_sync);
+	state.put(waiting_cwai);
+	state.put(nmi_previous);
+}
+
+void mc6809::restore_state(StateReader& state)
+{
+	USim::restore_state(state);
+
+	state.get(cc.all);
+	state.get(dp);
+	state.get(d);
+	state.get(x);
+	state.get(y);
+	state.get(u);
+	state.get(s);
+	state.get(waiting_sync);
+	state.get(waiting_cwai);
+	state.get(nmi_previous);
+
+	lazy = {};
+	idle_loop_instructions = 0;
+}
+
 void mc6809::tick()
 {
 	// handle the attached devices
 	USim::tick();
 
+	// run one instruction, or wait for an interrupt
+	step();
+
+	// then advance the clock, allowing one cycle for a wait
+	clock.now += cycles ? cycles : 1;
+	cycles = 0;
+}
+
+// What tick() does, until done() says to stop, but calling step()
+// directly rather than through the virtual tick() USim's loops use
+template<typename Done>
+inline Cycles mc6809::run_while_not(Done done)
+{
+	Cycles start = clock.now;
+
+	halted = false;
+	while (!halted && !done()) {
+		if (clock.now >= clock.next_event) {
+			tick_devices();
+		}
+		step();
+		clock.now += cycles ? cycles : 1;
+		cycles = 0;
+	}
+	return clock.now - start;
+}
+
+void mc6809::run()
+{
+	run_while_not([]() { return false; });
+}
+
+Cycles mc6809::run_for(Cycles n)
+{
+	run_limit = clock.now + n;
+	Cycles used = run_while_not([this]() { return clock.now >= run_limit; });
+	run_limit = UINT64_MAX;
+	return used;
+}
+
+Cycles mc6809::run_until(Word addr)
+{
+	return run_while_not([this, addr]() { return pc == addr; });
+}
+
+Cycles mc6809::run_until(const std::function<bool()>& done)
+{
+	return run_while_not(done);
+}
+
+void mc6809::step()
+{
 	// get interrupt pin states
-	bool c_nmi = NMI;
-	bool c_firq = FIRQ;
-	bool c_irq = IRQ;
+	bool c_nmi = NMI_line && NMI;
+	bool c_firq = FIRQ_line && FIRQ;
+	bool c_irq = IRQ_line && IRQ;
 
 	// check for NMI falling edge
 	bool nmi_triggered = !c_nmi && nmi_previous;
@@ -54,6 +145,7 @@ void mc6809::tick()
 		if (nmi_triggered || !c_firq || !c_irq) {
 			waiting_sync = false;
 		} else {
+			skip_idle(1);
 			return;
 		}
 	}
@@ -66,6 +158,7 @@ void mc6809::tick()
 	} else if (!c_irq && !cc.bit.i) {
 		do_irq();
 	} else if (waiting_cwai) {
+		skip_idle(1);
 		return;
 	}
 
@@ -74,21 +167,29 @@ void mc6809::tick()
 
 	// remember current instruction address
 	insn_pc = pc;
+	++instructions;
 
 	// hook
 	pre_exec();
 
-	// fetch the next instruction
-	fetch_instruction();
+	if (predecoded.empty()) {
+		// fetch the next instruction
+		fetch_instruction();
 
-	// and process it
-	execute_instruction();
+		// and process it
+		execute_instruction();
+	} else {
+		execute_predecoded();
+	}
 
 	// hook
 	post_exec();
 
-	// deduct a cycle to account for the one added in USim::tick
-	--cycles;
+#ifdef PROFILE
+	if (profiler) {
+		profiler->add(insn_pc, cycles);
+	}
+#endif
 }
 
 void mc6809::do_nmi()
@@ -99,6 +200,7 @@ void mc6809::do_nmi()
 	}
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfffc);
+	profile_call(s);
 }
 
 void mc6809::do_firq()
@@ -109,6 +211,7 @@ void mc6809::do_firq()
 	}
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfff6);
+	profile_call(s);
 }
 
 void mc6809::do_irq()
@@ -119,352 +222,501 @@ void mc6809::do_irq()
 	}
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfff8);
+	profile_call(s);
 }
 
 void mc6809::fetch_instruction()
 {
+	const opcode* page = opcodes;
+
 	ir = fetch();
 
 	// look for two-byte instructions
 	if (ir == 0x10 || ir == 0x11) {
+		page += (ir - 0x0f) * 256;
 		ir <<= 8;
 		ir |= fetch();
 	}
 
-	// Decode addressing mode
+	op = &page[ir & 0xff];
+	mode = op->mode;
+	insn = op->mnemonic;
+}
+
+void mc6809::execute_instruction()
+{
+	(this->*op->handler)();
+}
+
+//---------------------------------------------------------------------
+//
+// predecoded instruction cache
+//
+//---------------------------------------------------------------------
+
+void mc6809::predecode_on()
+{
+	predecoded.assign(0x10000, {});
+}
+
+void mc6809::predecode_off()
+{
+	predecoded.clear();
+	predecoded.shrink_to_fit();
+}
+
+// Runs the instruction at PC from the cache if its page has not been
+// written since it was decoded, otherwise decodes and executes it in
+// the usual way, recording the decode for next time
+void mc6809::execute_predecoded()
+{
+	decoded& d = predecoded[pc];
+	Byte page = pc >> 8;
+
+	if (d.op && d.gen == page_gen[page]) {
+		replaying = &d;
+		ir = d.ir;
+		op = d.op;
+		mode = op->mode;
+		insn = op->mnemonic;
+		pc += d.length;
+		cycles += d.opcode_length;
+		execute_instruction();
+		replaying = nullptr;
+		return;
+	}
+
+	uint32_t gen = page_gen[page];
+
+	d.op = nullptr;
+	recording = &d;
+	fetch_instruction();
+	d.opcode_length = d.length = pc - insn_pc;
+	execute_instruction();
+	recording = nullptr;
+
+	// only instructions held entirely within one page of
+	// plain memory can be revalidated by the page generation
+	if (pages[page].read && ((insn_pc + d.length - 1) >> 8) == page) {
+		d.op = op;
+		d.ir = ir;
+		d.gen = gen;
+	}
+}
+
+//---------------------------------------------------------------------
+//
+// opcode dispatch table
+//
+//---------------------------------------------------------------------
+
+// Addressing mode implied by an opcode, used to build the table
+mc6809::addressing_mode mc6809::decode_mode(Word ir)
+{
 	switch (ir & 0xf0) {
 		case 0x00: case 0x90: case 0xd0:
-			mode = direct; break;
+			return direct;
 		case 0x20:
-			mode = relative; break;
+			return relative;
 		case 0x30: case 0x40: case 0x50:
 			if (ir < 0x34) {
-				mode = indexed;
+				return indexed;
 			} else if (ir < 0x38 || ir == 0x3c) {
-				mode = immediate;
+				return immediate;
 			} else {
-				mode = inherent;
+				return inherent;
 			}
-			break;
 		case 0x60: case 0xa0: case 0xe0:
-			mode = indexed; break;
+			return indexed;
 		case 0x70: case 0xb0: case 0xf0:
-			mode = extended; break;
+			return extended;
 		case 0x80: case 0xc0:
 			if (ir == 0x8d) {
-				mode = relative;
+				return relative;
 			} else {
-				mode = immediate;
+				return immediate;
 			}
-			break;
 		case 0x10:
 			switch (ir & 0x0f) {
 				case 0x02: case 0x03: case 0x09: case 0x0d:
-					mode = inherent; break;
+					return inherent;
 				case 0x06: case 0x07:
-					mode = relative; break;
+					return relative;
 				case 0x0a: case 0x0c: case 0x0e: case 0x0f:
-					mode = immediate; break;
+					return immediate;
 			}
-			break;
 	}
+
+	return inherent;
 }
 
-void mc6809::execute_instruction()
+// One entry for each opcode in pages 0x00, 0x10 and 0x11.  Opcodes
+// not listed here are treated as NOP
+const mc6809::opcode* mc6809::opcode_table()
 {
-	switch (ir) {
-		case 0x3a:
-			abx(); break;
-		case 0x89: case 0x99: case 0xa9: case 0xb9:
-			adca(); break;
-		case 0xc9: case 0xd9: case 0xe9: case 0xf9:
-			adcb(); break;
-		case 0x8b: case 0x9b: case 0xab: case 0xbb:
-			adda(); break;
-		case 0xcb: case 0xdb: case 0xeb: case 0xfb:
-			addb(); break;
-		case 0xc3: case 0xd3: case 0xe3: case 0xf3:
-			addd(); break;
-		case 0x84: case 0x94: case 0xa4: case 0xb4:
-			anda(); break;
-		case 0xc4: case 0xd4: case 0xe4: case 0xf4:
-			andb(); break;
-		case 0x1c:
-			andcc(); break;
-		case 0x47:
-			asra(); break;
-		case 0x57:
-			asrb(); break;
-		case 0x07: case 0x67: case 0x77:
-			asr(); break;
-		case 0x24:
-			bcc(); break;
-		case 0x25:
-			bcs(); break;
-		case 0x27:
-			beq(); break;
-		case 0x2c:
-			bge(); break;
-		case 0x2e:
-			bgt(); break;
-		case 0x22:
-			bhi(); break;
-		case 0x85: case 0x95: case 0xa5: case 0xb5:
-			bita(); break;
-		case 0xc5: case 0xd5: case 0xe5: case 0xf5:
-			bitb(); break;
-		case 0x2f:
-			ble(); break;
-		case 0x23:
-			bls(); break;
-		case 0x2d:
-			blt(); break;
-		case 0x2b:
-			bmi(); break;
-		case 0x26:
-			bne(); break;
-		case 0x2a:
-			bpl(); break;
-		case 0x20:
-			bra(); break;
-		case 0x16:
-			lbra(); break;
-		case 0x21:
-			brn(); break;
-		case 0x8d:
-			bsr(); break;
-		case 0x17:
-			lbsr(); break;
-		case 0x28:
-			bvc(); break;
-		case 0x29:
-			bvs(); break;
-		case 0x4e: case 0x4f:
-			// 0x4e undocumented
-			clra(); break;
-		case 0x5e: case 0x5f:
-			// 0x5e undocumented
-			clrb(); break;
-		case 0x0f: case 0x6f: case 0x7f:
-			clr(); break;
-		case 0x81: case 0x91: case 0xa1: case 0xb1:
-			cmpa(); break;
-		case 0xc1: case 0xd1: case 0xe1: case 0xf1:
-			cmpb(); break;
-		case 0x1083: case 0x1093: case 0x10a3: case 0x10b3:
-			cmpd(); break;
-		case 0x118c: case 0x119c: case 0x11ac: case 0x11bc:
-			cmps(); break;
-		case 0x8c: case 0x9c: case 0xac: case 0xbc:
-			cmpx(); break;
-		case 0x1183: case 0x1193: case 0x11a3: case 0x11b3:
-			cmpu(); break;
-		case 0x108c: case 0x109c: case 0x10ac: case 0x10bc:
-			cmpy(); break;
-		case 0x42: case 0x43: case 0x1042:
-			// 0x42 / 0x1042 undocumented
-			coma(); break;
-		case 0x52: case 0x53:
-			// 0x52 undocumented
-			comb(); break;
-		case 0x03: case 0x62: case 0x63: case 0x73:
-			// 0x62 undocumented
-			com(); break;
-		case 0x3c:
-			cwai(); break;
-		case 0x19:
-			daa(); break;
-		case 0x4a: case 0x4b:
-			// 0x4b undocumented
-			deca(); break;
-		case 0x5a: case 0x5b:
-			// 0x5b undocumented
-			decb(); break;
-		case 0x0a: case 0x0b:
-		case 0x6a: case 0x6b:
-		case 0x7a: case 0x7b:
-			// 0x0b, 0x6b, 0x7b undocumented
-			dec(); break;
-		case 0x88: case 0x98: case 0xa8: case 0xb8:
-			eora(); break;
-		case 0xc8: case 0xd8: case 0xe8: case 0xf8:
-			eorb(); break;
-		case 0x1e:
-			exg(); break;
-		case 0x4c:
-			inca(); break;
-		case 0x5c:
-			incb(); break;
-		case 0x0c: case 0x6c: case 0x7c:
-			inc(); break;
-		case 0x0e: case 0x6e: case 0x7e:
-			jmp(); break;
-		case 0x9d: case 0xad: case 0xbd:
-			jsr(); break;
-		case 0x86: case 0x96: case 0xa6: case 0xb6:
-			lda(); break;
-		case 0xc6: case 0xd6: case 0xe6: case 0xf6:
-			ldb(); break;
-		case 0xcc: case 0xdc: case 0xec: case 0xfc:
-			ldd(); break;
-		case 0x10ce: case 0x10de: case 0x10ee: case 0x10fe:
-			lds(); break;
-		case 0xce: case 0xde: case 0xee: case 0xfe:
-			ldu(); break;
-		case 0x8e: case 0x9e: case 0xae: case 0xbe:
-			ldx(); break;
-		case 0x108e: case 0x109e: case 0x10ae: case 0x10be:
-			ldy(); break;
-		case 0x32:
-			leas(); break;
-		case 0x33:
-			leau(); break;
-		case 0x30:
-			leax(); break;
-		case 0x31:
-			leay(); break;
-		case 0x48:
-			lsla(); break;
-		case 0x58:
-			lslb(); break;
-		case 0x08: case 0x68: case 0x78:
-			lsl(); break;
-		case 0x44: case 0x45:
-			// 0x45 undocumented
-			lsra(); break;
-		case 0x54: case 0x55:
-			// 0x55 undocumented
-			lsrb(); break;
-		case 0x04: case 0x05:
-		case 0x64: case 0x65:
-		case 0x74: case 0x75:
-			// 0x05, 0x65, 0x75 undocumented
-			lsr(); break;
-		case 0x3d:
-			mul(); break;
-		case 0x40: case 0x41:
-			// 0x41 undocumented
-			nega(); break;
-		case 0x50: case 0x51:
-			// 0x51 undocumented
-			negb(); break;
-		case 0x00: case 0x01:
-		case 0x60: case 0x61:
-		case 0x70: case 0x71:
-			// 0x01, 0x61, 0x71 undocumented
-			neg(); break;
-		case 0x12:
-			nop(); break;
-		case 0x8a: case 0x9a: case 0xaa: case 0xba:
-			ora(); break;
-		case 0xca: case 0xda: case 0xea: case 0xfa:
-			orb(); break;
-		case 0x1a:
-			orcc(); break;
-		case 0x34:
-			pshs(); break;
-		case 0x36:
-			pshu(); break;
-		case 0x35:
-			puls(); break;
-		case 0x37:
-			pulu(); break;
-		case 0x49:
-			rola(); break;	
-		case 0x59:
-			rolb(); break;
-		case 0x09: case 0x69: case 0x79:
-			rol(); break;
-		case 0x46:
-			rora(); break;	
-		case 0x56:
-			rorb(); break;
-		case 0x06: case 0x66: case 0x76:
-			ror(); break;
-		case 0x3b:
-			rti(); break;
-		case 0x39:
-			rts(); break;
-		case 0x82: case 0x92: case 0xa2: case 0xb2: 
-			sbca(); break;
-		case 0xc2: case 0xd2: case 0xe2: case 0xf2: 
-			sbcb(); break;
-		case 0x1d:
-			sex(); break;
-		case 0x97: case 0xa7: case 0xb7:
-			sta(); break;
-		case 0xd7: case 0xe7: case 0xf7:
-			stb(); break;
-		case 0xdd: case 0xed: case 0xfd:
-			std(); break;
-		case 0x10df: case 0x10ef: case 0x10ff:
-			sts(); break;
-		case 0xdf: case 0xef: case 0xff:
-			stu(); break;
-		case 0x9f: case 0xaf: case 0xbf:
-			stx(); break;
-		case 0x109f: case 0x10af: case 0x10bf:
-			sty(); break;
-		case 0x80: case 0x90: case 0xa0: case 0xb0:
-			suba(); break;
-		case 0xc0: case 0xd0: case 0xe0: case 0xf0:
-			subb(); break;
-		case 0x83: case 0x93: case 0xa3: case 0xb3:
-			subd(); break;
-		case 0x3f:
-			swi(); break;
-		case 0x103f:
-			swi2(); break;
-		case 0x113f:
-			swi3(); break;
-		case 0x13:
-			sync(); break;
-		case 0x1f:
-			tfr(); break;
-		case 0x4d:
-			tsta(); break;
-		case 0x5d:
-			tstb(); break;
-		case 0x0d: case 0x6d: case 0x7d:
-			tst(); break;
-		case 0x1024:
-			lbcc(); break;
-		case 0x1025:
-			lbcs(); break;
-		case 0x1027:
-			lbeq(); break;
-		case 0x102c:
-			lbge(); break;
-		case 0x102e:
-			lbgt(); break;
-		case 0x1022:
-			lbhi(); break;
-		case 0x102f:
-			lble(); break;
-		case 0x1023:
-			lbls(); break;
-		case 0x102d:
-			lblt(); break;
-		case 0x102b:
-			lbmi(); break;
-		case 0x1026:
-			lbne(); break;
-		case 0x102a:
-			lbpl(); break;
-		case 0x1021:
-			lbrn(); break;
-		case 0x1028:
-			lbvc(); break;
-		case 0x1029:
-			lbvs(); break;
-		default:
-            nop();  // Treat invalid instruction as NOP
-			// invalid("invalid instruction");
+	static const struct {
+		Word		ir;
+		void		(mc6809::*handler)();
+		const char*	mnemonic;
+	} defs[] = {
+		{ 0x00,	&mc6809::neg,			"NEG" },
+		{ 0x01,	&mc6809::neg,			"NEG" },	// undocumented
+		{ 0x03,	&mc6809::com,			"COM" },
+		{ 0x04,	&mc6809::lsr,			"LSR" },
+		{ 0x05,	&mc6809::lsr,			"LSR" },	// undocumented
+		{ 0x06,	&mc6809::ror,			"ROR" },
+		{ 0x07,	&mc6809::asr,			"ASR" },
+		{ 0x08,	&mc6809::lsl,			"LSL" },
+		{ 0x09,	&mc6809::rol,			"ROL" },
+		{ 0x0a,	&mc6809::dec,			"DEC" },
+		{ 0x0b,	&mc6809::dec,			"DEC" },	// undocumented
+		{ 0x0c,	&mc6809::inc,			"INC" },
+		{ 0x0d,	&mc6809::tst,			"TST" },
+		{ 0x0e,	&mc6809::jmp,			"JMP" },
+		{ 0x0f,	&mc6809::clr,			"CLR" },
+		{ 0x12,	&mc6809::nop,			"NOP" },
+		{ 0x13,	&mc6809::sync,			"SYNC" },
+		{ 0x16,	&mc6809::lbra,			"LBRA" },
+		{ 0x17,	&mc6809::lbsr,			"LBSR" },
+		{ 0x19,	&mc6809::daa,			"DAA" },
+		{ 0x1a,	&mc6809::orcc,			"ORCC" },
+		{ 0x1c,	&mc6809::andcc,			"ANDCC" },
+		{ 0x1d,	&mc6809::sex,			"SEX" },
+		{ 0x1e,	&mc6809::exg,			"EXG" },
+		{ 0x1f,	&mc6809::tfr,			"TFR" },
+		{ 0x20,	&mc6809::bra,			"BRA" },
+		{ 0x21,	&mc6809::brn,			"BRN" },
+		{ 0x22,	&mc6809::bhi,			"BHI" },
+		{ 0x23,	&mc6809::bls,			"BLS" },
+		{ 0x24,	&mc6809::bcc,			"BCC" },
+		{ 0x25,	&mc6809::bcs,			"BCS" },
+		{ 0x26,	&mc6809::bne,			"BNE" },
+		{ 0x27,	&mc6809::beq,			"BEQ" },
+		{ 0x28,	&mc6809::bvc,			"BVC" },
+		{ 0x29,	&mc6809::bvs,			"BVS" },
+		{ 0x2a,	&mc6809::bpl,			"BPL" },
+		{ 0x2b,	&mc6809::bmi,			"BMI" },
+		{ 0x2c,	&mc6809::bge,			"BGE" },
+		{ 0x2d,	&mc6809::blt,			"BLT" },
+		{ 0x2e,	&mc6809::bgt,			"BGT" },
+		{ 0x2f,	&mc6809::ble,			"BLE" },
+		{ 0x30,	&mc6809::leax,			"LEAX" },
+		{ 0x31,	&mc6809::leay,			"LEAY" },
+		{ 0x32,	&mc6809::leas,			"LEAS" },
+		{ 0x33,	&mc6809::leau,			"LEAU" },
+		{ 0x34,	&mc6809::pshs,			"PSHS" },
+		{ 0x35,	&mc6809::puls,			"PULS" },
+		{ 0x36,	&mc6809::pshu,			"PSHU" },
+		{ 0x37,	&mc6809::pulu,			"PULU" },
+		{ 0x39,	&mc6809::rts,			"RTS" },
+		{ 0x3a,	&mc6809::abx,			"ABX" },
+		{ 0x3b,	&mc6809::rti,			"RTI" },
+		{ 0x3c,	&mc6809::cwai,			"CWAI" },
+		{ 0x3d,	&mc6809::mul,			"MUL" },
+		{ 0x3f,	&mc6809::swi,			"SWI" },
+		{ 0x40,	&mc6809::nega,			"NEGA" },
+		{ 0x41,	&mc6809::nega,			"NEGA" },	// undocumented
+		{ 0x42,	&mc6809::coma,			"COMA" },	// undocumented
+		{ 0x43,	&mc6809::coma,			"COMA" },
+		{ 0x44,	&mc6809::lsra,			"LSRA" },
+		{ 0x45,	&mc6809::lsra,			"LSRA" },	// undocumented
+		{ 0x46,	&mc6809::rora,			"RORA" },
+		{ 0x47,	&mc6809::asra,			"ASRA" },
+		{ 0x48,	&mc6809::lsla,			"LSLA" },
+		{ 0x49,	&mc6809::rola,			"ROLA" },
+		{ 0x4a,	&mc6809::deca,			"DECA" },
+		{ 0x4b,	&mc6809::deca,			"DECA" },	// undocumented
+		{ 0x4c,	&mc6809::inca,			"INCA" },
+		{ 0x4d,	&mc6809::tsta,			"TSTA" },
+		{ 0x4e,	&mc6809::clra,			"CLRA" },	// undocumented
+		{ 0x4f,	&mc6809::clra,			"CLRA" },
+		{ 0x50,	&mc6809::negb,			"NEGB" },
+		{ 0x51,	&mc6809::negb,			"NEGB" },	// undocumented
+		{ 0x52,	&mc6809::comb,			"COMB" },	// undocumented
+		{ 0x53,	&mc6809::comb,			"COMB" },
+		{ 0x54,	&mc6809::lsrb,			"LSRB" },
+		{ 0x55,	&mc6809::lsrb,			"LSRB" },	// undocumented
+		{ 0x56,	&mc6809::rorb,			"RORB" },
+		{ 0x57,	&mc6809::asrb,			"ASRB" },
+		{ 0x58,	&mc6809::lslb,			"LSLB" },
+		{ 0x59,	&mc6809::rolb,			"ROLB" },
+		{ 0x5a,	&mc6809::decb,			"DECB" },
+		{ 0x5b,	&mc6809::decb,			"DECB" },	// undocumented
+		{ 0x5c,	&mc6809::incb,			"INCB" },
+		{ 0x5d,	&mc6809::tstb,			"TSTB" },
+		{ 0x5e,	&mc6809::clrb,			"CLRB" },	// undocumented
+		{ 0x5f,	&mc6809::clrb,			"CLRB" },
+		{ 0x60,	&mc6809::neg,			"NEG" },
+		{ 0x61,	&mc6809::neg,			"NEG" },	// undocumented
+		{ 0x62,	&mc6809::com,			"COM" },	// undocumented
+		{ 0x63,	&mc6809::com,			"COM" },
+		{ 0x64,	&mc6809::lsr,			"LSR" },
+		{ 0x65,	&mc6809::lsr,			"LSR" },	// undocumented
+		{ 0x66,	&mc6809::ror,			"ROR" },
+		{ 0x67,	&mc6809::asr,			"ASR" },
+		{ 0x68,	&mc6809::lsl,			"LSL" },
+		{ 0x69,	&mc6809::rol,			"ROL" },
+		{ 0x6a,	&mc6809::dec,			"DEC" },
+		{ 0x6b,	&mc6809::dec,			"DEC" },	// undocumented
+		{ 0x6c,	&mc6809::inc,			"INC" },
+		{ 0x6d,	&mc6809::tst,			"TST" },
+		{ 0x6e,	&mc6809::jmp,			"JMP" },
+		{ 0x6f,	&mc6809::clr,			"CLR" },
+		{ 0x70,	&mc6809::neg,			"NEG" },
+		{ 0x71,	&mc6809::neg,			"NEG" },	// undocumented
+		{ 0x73,	&mc6809::com,			"COM" },
+		{ 0x74,	&mc6809::lsr,			"LSR" },
+		{ 0x75,	&mc6809::lsr,			"LSR" },	// undocumented
+		{ 0x76,	&mc6809::ror,			"ROR" },
+		{ 0x77,	&mc6809::asr,			"ASR" },
+		{ 0x78,	&mc6809::lsl,			"LSL" },
+		{ 0x79,	&mc6809::rol,			"ROL" },
+		{ 0x7a,	&mc6809::dec,			"DEC" },
+		{ 0x7b,	&mc6809::dec,			"DEC" },	// undocumented
+		{ 0x7c,	&mc6809::inc,			"INC" },
+		{ 0x7d,	&mc6809::tst,			"TST" },
+		{ 0x7e,	&mc6809::jmp,			"JMP" },
+		{ 0x7f,	&mc6809::clr,			"CLR" },
+		{ 0x80,	&mc6809::suba,			"SUBA" },
+		{ 0x81,	&mc6809::cmpa,			"CMPA" },
+		{ 0x82,	&mc6809::sbca,			"SBCA" },
+		{ 0x83,	&mc6809::subd,			"SUBD" },
+		{ 0x84,	&mc6809::anda,			"ANDA" },
+		{ 0x85,	&mc6809::bita,			"BITA" },
+		{ 0x86,	&mc6809::lda,			"LDA" },
+		{ 0x88,	&mc6809::eora,			"EORA" },
+		{ 0x89,	&mc6809::adca,			"ADCA" },
+		{ 0x8a,	&mc6809::ora,			"ORA" },
+		{ 0x8b,	&mc6809::adda,			"ADDA" },
+		{ 0x8c,	&mc6809::cmpx,			"CMPX" },
+		{ 0x8d,	&mc6809::bsr,			"BSR" },
+		{ 0x8e,	&mc6809::ldx,			"LDX" },
+		{ 0x90,	&mc6809::suba,			"SUBA" },
+		{ 0x91,	&mc6809::cmpa,			"CMPA" },
+		{ 0x92,	&mc6809::sbca,			"SBCA" },
+		{ 0x93,	&mc6809::subd,			"SUBD" },
+		{ 0x94,	&mc6809::anda,			"ANDA" },
+		{ 0x95,	&mc6809::bita,			"BITA" },
+		{ 0x96,	&mc6809::lda,			"LDA" },
+		{ 0x97,	&mc6809::sta,			"STA" },
+		{ 0x98,	&mc6809::eora,			"EORA" },
+		{ 0x99,	&mc6809::adca,			"ADCA" },
+		{ 0x9a,	&mc6809::ora,			"ORA" },
+		{ 0x9b,	&mc6809::adda,			"ADDA" },
+		{ 0x9c,	&mc6809::cmpx,			"CMPX" },
+		{ 0x9d,	&mc6809::jsr,			"JSR" },
+		{ 0x9e,	&mc6809::ldx,			"LDX" },
+		{ 0x9f,	&mc6809::stx,			"STX" },
+		{ 0xa0,	&mc6809::suba,			"SUBA" },
+		{ 0xa1,	&mc6809::cmpa,			"CMPA" },
+		{ 0xa2,	&mc6809::sbca,			"SBCA" },
+		{ 0xa3,	&mc6809::subd,			"SUBD" },
+		{ 0xa4,	&mc6809::anda,			"ANDA" },
+		{ 0xa5,	&mc6809::bita,			"BITA" },
+		{ 0xa6,	&mc6809::lda,			"LDA" },
+		{ 0xa7,	&mc6809::sta,			"STA" },
+		{ 0xa8,	&mc6809::eora,			"EORA" },
+		{ 0xa9,	&mc6809::adca,			"ADCA" },
+		{ 0xaa,	&mc6809::ora,			"ORA" },
+		{ 0xab,	&mc6809::adda,			"ADDA" },
+		{ 0xac,	&mc6809::cmpx,			"CMPX" },
+		{ 0xad,	&mc6809::jsr,			"JSR" },
+		{ 0xae,	&mc6809::ldx,			"LDX" },
+		{ 0xaf,	&mc6809::stx,			"STX" },
+		{ 0xb0,	&mc6809::suba,			"SUBA" },
+		{ 0xb1,	&mc6809::cmpa,			"CMPA" },
+		{ 0xb2,	&mc6809::sbca,			"SBCA" },
+		{ 0xb3,	&mc6809::subd,			"SUBD" },
+		{ 0xb4,	&mc6809::anda,			"ANDA" },
+		{ 0xb5,	&mc6809::bita,			"BITA" },
+		{ 0xb6,	&mc6809::lda,			"LDA" },
+		{ 0xb7,	&mc6809::sta,			"STA" },
+		{ 0xb8,	&mc6809::eora,			"EORA" },
+		{ 0xb9,	&mc6809::adca,			"ADCA" },
+		{ 0xba,	&mc6809::ora,			"ORA" },
+		{ 0xbb,	&mc6809::adda,			"ADDA" },
+		{ 0xbc,	&mc6809::cmpx,			"CMPX" },
+		{ 0xbd,	&mc6809::jsr,			"JSR" },
+		{ 0xbe,	&mc6809::ldx,			"LDX" },
+		{ 0xbf,	&mc6809::stx,			"STX" },
+		{ 0xc0,	&mc6809::subb,			"SUBB" },
+		{ 0xc1,	&mc6809::cmpb,			"CMPB" },
+		{ 0xc2,	&mc6809::sbcb,			"SBCB" },
+		{ 0xc3,	&mc6809::addd,			"ADDD" },
+		{ 0xc4,	&mc6809::andb,			"ANDB" },
+		{ 0xc5,	&mc6809::bitb,			"BITB" },
+		{ 0xc6,	&mc6809::ldb,			"LDB" },
+		{ 0xc8,	&mc6809::eorb,			"EORB" },
+		{ 0xc9,	&mc6809::adcb,			"ADCB" },
+		{ 0xca,	&mc6809::orb,			"ORB" },
+		{ 0xcb,	&mc6809::addb,			"ADDB" },
+		{ 0xcc,	&mc6809::ldd,			"LDD" },
+		{ 0xce,	&mc6809::ldu,			"LDU" },
+		{ 0xd0,	&mc6809::subb,			"SUBB" },
+		{ 0xd1,	&mc6809::cmpb,			"CMPB" },
+		{ 0xd2,	&mc6809::sbcb,			"SBCB" },
+		{ 0xd3,	&mc6809::addd,			"ADDD" },
+		{ 0xd4,	&mc6809::andb,			"ANDB" },
+		{ 0xd5,	&mc6809::bitb,			"BITB" },
+		{ 0xd6,	&mc6809::ldb,			"LDB" },
+		{ 0xd7,	&mc6809::stb,			"STB" },
+		{ 0xd8,	&mc6809::eorb,			"EORB" },
+		{ 0xd9,	&mc6809::adcb,			"ADCB" },
+		{ 0xda,	&mc6809::orb,			"ORB" },
+		{ 0xdb,	&mc6809::addb,			"ADDB" },
+		{ 0xdc,	&mc6809::ldd,			"LDD" },
+		{ 0xdd,	&mc6809::std,			"STD" },
+		{ 0xde,	&mc6809::ldu,			"LDU" },
+		{ 0xdf,	&mc6809::stu,			"STU" },
+		{ 0xe0,	&mc6809::subb,			"SUBB" },
+		{ 0xe1,	&mc6809::cmpb,			"CMPB" },
+		{ 0xe2,	&mc6809::sbcb,			"SBCB" },
+		{ 0xe3,	&mc6809::addd,			"ADDD" },
+		{ 0xe4,	&mc6809::andb,			"ANDB" },
+		{ 0xe5,	&mc6809::bitb,			"BITB" },
+		{ 0xe6,	&mc6809::ldb,			"LDB" },
+		{ 0xe7,	&mc6809::stb,			"STB" },
+		{ 0xe8,	&mc6809::eorb,			"EORB" },
+		{ 0xe9,	&mc6809::adcb,			"ADCB" },
+		{ 0xea,	&mc6809::orb,			"ORB" },
+		{ 0xeb,	&mc6809::addb,			"ADDB" },
+		{ 0xec,	&mc6809::ldd,			"LDD" },
+		{ 0xed,	&mc6809::std,			"STD" },
+		{ 0xee,	&mc6809::ldu,			"LDU" },
+		{ 0xef,	&mc6809::stu,			"STU" },
+		{ 0xf0,	&mc6809::subb,			"SUBB" },
+		{ 0xf1,	&mc6809::cmpb,			"CMPB" },
+		{ 0xf2,	&mc6809::sbcb,			"SBCB" },
+		{ 0xf3,	&mc6809::addd,			"ADDD" },
+		{ 0xf4,	&mc6809::andb,			"ANDB" },
+		{ 0xf5,	&mc6809::bitb,			"BITB" },
+		{ 0xf6,	&mc6809::ldb,			"LDB" },
+		{ 0xf7,	&mc6809::stb,			"STB" },
+		{ 0xf8,	&mc6809::eorb,			"EORB" },
+		{ 0xf9,	&mc6809::adcb,			"ADCB" },
+		{ 0xfa,	&mc6809::orb,			"ORB" },
+		{ 0xfb,	&mc6809::addb,			"ADDB" },
+		{ 0xfc,	&mc6809::ldd,			"LDD" },
+		{ 0xfd,	&mc6809::std,			"STD" },
+		{ 0xfe,	&mc6809::ldu,			"LDU" },
+		{ 0xff,	&mc6809::stu,			"STU" },
+
+		{ 0x1021,	&mc6809::lbrn,		"LBRN" },
+		{ 0x1022,	&mc6809::lbhi,		"LBHI" },
+		{ 0x1023,	&mc6809::lbls,		"LBLS" },
+		{ 0x1024,	&mc6809::lbcc,		"LBCC" },
+		{ 0x1025,	&mc6809::lbcs,		"LBCS" },
+		{ 0x1026,	&mc6809::lbne,		"LBNE" },
+		{ 0x1027,	&mc6809::lbeq,		"LBEQ" },
+		{ 0x1028,	&mc6809::lbvc,		"LBVC" },
+		{ 0x1029,	&mc6809::lbvs,		"LBVS" },
+		{ 0x102a,	&mc6809::lbpl,		"LBPL" },
+		{ 0x102b,	&mc6809::lbmi,		"LBMI" },
+		{ 0x102c,	&mc6809::lbge,		"LBGE" },
+		{ 0x102d,	&mc6809::lblt,		"LBLT" },
+		{ 0x102e,	&mc6809::lbgt,		"LBGT" },
+		{ 0x102f,	&mc6809::lble,		"LBLE" },
+		{ 0x103f,	&mc6809::swi2,		"SWI2" },
+		{ 0x1042,	&mc6809::coma,		"COMA" },	// undocumented
+		{ 0x1083,	&mc6809::cmpd,		"CMPD" },
+		{ 0x108c,	&mc6809::cmpy,		"CMPY" },
+		{ 0x108e,	&mc6809::ldy,		"LDY" },
+		{ 0x1093,	&mc6809::cmpd,		"CMPD" },
+		{ 0x109c,	&mc6809::cmpy,		"CMPY" },
+		{ 0x109e,	&mc6809::ldy,		"LDY" },
+		{ 0x109f,	&mc6809::sty,		"STY" },
+		{ 0x10a3,	&mc6809::cmpd,		"CMPD" },
+		{ 0x10ac,	&mc6809::cmpy,		"CMPY" },
+		{ 0x10ae,	&mc6809::ldy,		"LDY" },
+		{ 0x10af,	&mc6809::sty,		"STY" },
+		{ 0x10b3,	&mc6809::cmpd,		"CMPD" },
+		{ 0x10bc,	&mc6809::cmpy,		"CMPY" },
+		{ 0x10be,	&mc6809::ldy,		"LDY" },
+		{ 0x10bf,	&mc6809::sty,		"STY" },
+		{ 0x10ce,	&mc6809::lds,		"LDS" },
+		{ 0x10de,	&mc6809::lds,		"LDS" },
+		{ 0x10df,	&mc6809::sts,		"STS" },
+		{ 0x10ee,	&mc6809::lds,		"LDS" },
+		{ 0x10ef,	&mc6809::sts,		"STS" },
+		{ 0x10fe,	&mc6809::lds,		"LDS" },
+		{ 0x10ff,	&mc6809::sts,		"STS" },
+
+		{ 0x113f,	&mc6809::swi3,		"SWI3" },
+		{ 0x1183,	&mc6809::cmpu,		"CMPU" },
+		{ 0x118c,	&mc6809::cmps,		"CMPS" },
+		{ 0x1193,	&mc6809::cmpu,		"CMPU" },
+		{ 0x119c,	&mc6809::cmps,		"CMPS" },
+		{ 0x11a3,	&mc6809::cmpu,		"CMPU" },
+		{ 0x11ac,	&mc6809::cmps,		"CMPS" },
+		{ 0x11b3,	&mc6809::cmpu,		"CMPU" },
+		{ 0x11bc,	&mc6809::cmps,		"CMPS" },
+	};
+
+	static const std::vector<opcode> table = [] {
+		std::vector<opcode> t(3 * 256);
+
+		for (Word page = 0; page < 3; ++page) {
+			Word prefix = page ? (page + 0x0f) << 8 : 0;
+			for (Word i = 0; i < 256; ++i) {
+				t[page * 256 + i] = { &mc6809::nop, decode_mode(prefix | i), "NOP" };
+			}
+		}
+
+		for (auto& def : defs) {
+			Word page = (def.ir >> 8) ? (def.ir >> 8) - 0x0f : 0;
+			t[page * 256 + (def.ir & 0xff)] = { def.handler, decode_mode(def.ir), def.mnemonic };
+		}
+
+		return t;
+	}();
+
+	return table.data();
+}
+
+// A backward branch taken again from the same register state,
+// with nothing written in between, is in a loop that will keep
+// going round unchanged until some device next acts, so skip
+// as many whole iterations as fit before then
+void mc6809::check_idle_loop()
+{
+	loop_state state = { insn_pc, d, x, y, u, s, dp, cc.all, lazy, side_effects };
+
+	// nothing has been recorded while idle_loop_instructions is zero
+	if (idle_loop_instructions && state == idle_loop && !m_trace && !tracer) {
+		uint64_t n = skip_idle(clock.now - idle_loop_time);
+		instructions += n * (instructions - idle_loop_instructions);
+	}
+
+	idle_loop = state;
+	idle_loop_time = clock.now;
+	idle_loop_instructions = instructions;
+}
+
+bool mc6809::loop_state::operator==(const loop_state& o) const
+{
+	return pc == o.pc && d == o.d && x == o.x && y == o.y &&
+		u == o.u && s == o.s && dp == o.dp && cc == o.cc &&
+		lazy.width == o.lazy.width && lazy.half == o.lazy.half &&
+		lazy.x == o.lazy.x && lazy.m == o.lazy.m && lazy.t == o.lazy.t &&
+		side_effects == o.side_effects;
+}
+
+void mc6809::eval_deferred_cc()
+{
+	if (lazy.half) {
+		cc.bit.h = btst((Word)(lazy.x ^ lazy.m ^ lazy.t), 4);
 	}
+	cc.bit.c = flag_c();
+	cc.bit.v = flag_v();
+	cc.bit.z = flag_z();
+	cc.bit.n = flag_n();
+	lazy.width = 0;
+	lazy.half = false;
 }
 
 void mc6809::print_regs()
 {
+	eval_cc();
 	char flags[] = "EFHINZVC";
 	for (uint8_t i = 0, mask = 0x80; mask; ++i, mask >>= 1) {
 		if ((cc.all & mask) == 0) {
@@ -477,23 +729,53 @@ void mc6809::print_regs()
 
 void mc6809::pre_exec()
 {
+	if (tracer) {
+		record_regs(tracer->next());
+	}
+
 	if (!m_trace) return;
 
 	print_regs();
+
+	Byte code[5];
+	peek(pc, code, sizeof code);
+	disasm.decode(code, sizeof code, pc, traced);
 }
 
 void mc6809::post_exec()
 {
+	if (tracer) {
+		tracer->next().cycles = cycles;
+		tracer->commit();
+	}
+
 	if (!m_trace) return;
 
-	fprintf(stderr, "/ %04X: [%2d] %-8s%s\r\n", insn_pc, cycles, insn, disasm_operand().c_str());
+	fprintf(stderr, "/ %04X: [%2d] %-8s%s\r\n", insn_pc, cycles, traced.mnemonic, traced.operand);
+}
+
+// the binary trace equivalent of print_regs()
+void mc6809::record_regs(TraceRecord& r)
+{
+	eval_cc();
+	r.time = clock.now;
+	r.pc = pc;
+	r.cc = cc.all;
+	r.s = s;
+	r.u = u;
+	r.a = a;
+	r.b = b;
+	r.e = 0;
+	r.f = 0;
+	r.x = x;
+	r.y = y;
+	r.dp = dp;
+	peek(pc, r.code, sizeof r.code);
 }
 
 // used for EXG and TFR instructions
 Word& mc6809::wordrefreg(int r)
 {
-	static Word no_return = 0;
-
 	switch (r) {
 		case  0: return d;
 		case  1: return x;
@@ -504,29 +786,25 @@ Word& mc6809::wordrefreg(int r)
 	}
 
 	invalid("invalid word register selector");
-	return no_return;
+	return no_return_word;
 }
 
 Byte& mc6809::byterefreg(int r)
 {
-	static Byte no_return = 0;
-
 	switch (r) {
 		case  8: return a;
 		case  9: return b;
-		case 10: return cc.all;
+		case 10: eval_cc(); return cc.all;
 		case 11: return dp;
 	}
 
 	invalid("invalid byte register selector");
-	return no_return;
+	return no_return_byte;
 }
 
 // decodes the postbyte for most indexed modes
 Word& mc6809::ix_refreg(Byte post)
 {
-	static Word no_return = 0;
-
 	post = (post >> 5) & 0x03;
 	switch (post) {
 		case 0: return x;
@@ -536,16 +814,16 @@ Word& mc6809::ix_refreg(Byte post)
 	}
 
 	invalid("invalid register reference");
-	return no_return;
+	return no_return_word;
 }
 
 Byte mc6809::fetch_operand()
 {
 	switch (mode) {
 		case immediate:
-			return operand = extend8(fetch());
+			return operand = extend8(fetch_operand_byte());
 		case relative: {
-			Byte r = fetch();
+			Byte r = fetch_operand_byte();
 			operand = pc + extend8(r);
 			return r;
 		}
@@ -558,9 +836,9 @@ Word mc6809::fetch_word_operand()
 {
 	switch (mode) {
 		case immediate:
-			return operand = fetch_word();
+			return operand = fetch_operand_word();
 		case relative: {
-			Word r = fetch_word();
+			Word r = fetch_operand_word();
 			operand = pc + r;
 			return r;
 		}
@@ -574,13 +852,13 @@ Word mc6809::fetch_effective_address()
 	switch (mode) {
 		case extended:
 			++cycles;
-			return operand = fetch_word();
+			return operand = fetch_operand_word();
 		case direct:
 			++cycles;
-			operand = fetch();
+			operand = fetch_operand_byte();
 			return ((Word)dp << 8) | operand;
 		case indexed: {
-			post = fetch();
+			post = fetch_postbyte();
 
 			do_predecrement();
 			Word addr = fetch_indexed_operand();
@@ -631,26 +909,26 @@ Word mc6809::fetch_indexed_operand()
 			return extend8(a) + ix_refreg(post);
 		case 0x08: case 0x18:		// ,R + 8 bit
 			cycles += 1;
-			operand = extend8(fetch());
+			operand = extend8(fetch_operand_byte());
 			return ix_refreg(post) + operand;
 		case 0x09: case 0x19:		// ,R + 16 bit
 			cycles += 3;
-			operand = fetch_word();
+			operand = fetch_operand_word();
 			return ix_refreg(post) + operand;
 		case 0x0b: case 0x1b:		// ,R + D
 			cycles += 5;
 			return d + ix_refreg(post);
 		case 0x0c: case 0x1c:		// ,PC + 8
 			cycles += 1;
-			operand = extend8(fetch());
+			operand = extend8(fetch_operand_byte());
 			return pc + operand;
 		case 0x0d: case 0x1d:		// ,PC + 16
 			cycles += 3;
-			operand = fetch_word();
+			operand = fetch_operand_word();
 			return pc + operand;
 		case 0x1f:			// [,Address]
 			cycles += 1;
-			operand = fetch_word();
+			operand = fetch_operand_word();
 			return operand;
 		default:
 			invalid("invalid indexed addressing postbyte");
@@ -687,130 +965,3 @@ void mc6809::do_predecrement()
 			break;
 	}
 }
-
-//---------------------------------------------------------------------
-//
-// disassembly support
-//
-//---------------------------------------------------------------------
-
-static std::string disasm_reglist(Byte w, const char *other_sr)
-{
-        static const char* regs[]  = {
-                "CC", "A", "B", "DP", "X", "Y", "", "PC"
-        };
-
-        std::string r;
-
-        for (int n = 0; (n < 8) && w; ++n, w >>= 1) {
-                if (w & 1) {
-                        r += (n == 6) ? other_sr : regs[n];
-                        if (w & 0xfe) {
-                                r += ",";
-                        }
-                }
-        }
-
-        return r;
-}
-
-static std::string disasm_regpair(Byte w)
-{
-	static const char* regnames[] = {
-		"D", "X", "Y", "U", "S", "PC", "", "",
-		"A", "B", "CC", "DP", "", "", "", ""
-	};
-
-	int r1 = (w & 0xf0) >> 4;
-	int r2 = (w & 0x0f) >> 0;
-
-	return std::string(regnames[r1]) + "," + std::string(regnames[r2]);
-}
-
-template<typename ... Args>
-static std::string fmt(const std::string& format, Args ... args)
-{
-	int size = ::snprintf(nullptr, 0, format.c_str(), args ...) + 1;
-	if (size <= 0) {
-		return "string formatting error";
-	}
-
-	std::unique_ptr<char[]> buf(new char[size]);
-	::snprintf(buf.get(), size, format.c_str(), args ...);
-	return std::string(buf.get(), buf.get() + size - 1 );
-}
-
-std::string mc6809::disasm_indexed()
-{
-	static const char regs[] = "XYUS";
-	const char reg = regs[(post >> 5) & 0x03];
-
-	if (!btst(post, 7)) {			// ,R + 5 bit offset
-		return fmt("%d,%c", (int16_t)extend5(post & 0x1f), reg);
-	}
-
-	switch (post & 0x1f) {
-		case 0x00:			// ,R+
-			return fmt(",%c+", reg);
-		case 0x01: case 0x11:		// ,R++
-			return fmt(",%c++", reg);
-		case 0x02:			// ,-R
-			return fmt(",-%c", reg);
-		case 0x03: case 0x13:		// ,--R
-			return fmt(",--%c", reg);
-		case 0x04: case 0x14:		// ,R + 0
-			return fmt(",%c", reg);
-		case 0x05: case 0x15:		// ,R + B
-			return fmt("B,%c", reg);
-		case 0x06: case 0x16:		// ,R + A
-			return fmt("A,%c", reg);
-		case 0x08: case 0x18:		// ,R + offset
-		case 0x09: case 0x19:
-			return fmt("%d,%c", (int16_t)operand, reg);
-		case 0x0b: case 0x1b:		// ,R + D
-			return fmt("D,%c", reg);
-		case 0x0c: case 0x1c:		// ,PCR + offset
-		case 0x0d: case 0x1d:
-			return fmt("%d,PCR", (int16_t)operand, reg);
-		case 0x1f:			// ,Address
-			return fmt(",$%04hx", (int16_t)operand);
-		default:
-			invalid("indirect addressing postbyte");
-			return "";
-	}
-}
-
-std::string mc6809::disasm_operand()
-{
-	// special cases for PSHx / PULx / EXG / TFR
-	switch (ir) {
-		case 0x34: case 0x36:	// PSHS / PULS
-			return disasm_reglist(operand, "U");
-		case 0x35: case 0x37:	// PSHU / PULU
-			return disasm_reglist(operand, "S");
-		case 0x1e: case 0x1f:	// EXG / TFR
-			return disasm_regpair(operand);
-	}
-
-	switch (mode) {
-		case inherent:
-			return "";
-		case immediate:
-			return fmt("#$%02X", operand);
-		case relative:
-			return fmt("$%04X", operand);
-		case direct:
-			return fmt("<$%02X", operand);
-		case extended:
-			return fmt("$%04X", operand);
-		case indexed: {
-			auto r = disasm_indexed();
-			if (btst(post, 4) && btst(post, 7)) {
-				r = "[" + r + "]";
-			}
-			return r;
-		}
-	}
-
-	return "";
-}
@@ -9,8 +9,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "wiring.h"
 #include "usim.h"
+#include "disasm.h"
 #include "bits.h"
 
 #ifndef USIM_MACHDEP_H
@@ -21,7 +23,7 @@ class mc6809 : virtual public USimMotorola {
 
 protected: // Processor addressing modes
 
-	enum {
+	enum addressing_mode {
 				immediate,
 				direct,
 				indexed,
@@ -75,15 +77,95 @@ protected:	// Processor registers
 		} bit;
 	} cc;
 
+protected:	// lazily evaluated condition codes
+	//
+	// the common arithmetic instructions only record their operands
+	// and result here, and N, Z, V, C (and H for 8 bit additions) are
+	// worked out when something actually looks at them.  Code that
+	// reads or partially updates those bits of cc must call eval_cc()
+	// first.
+	struct deferred_cc {
+		Byte		width;		// 8 or 16, 0 if cc is up to date
+		bool		half;		// H is deferred too
+		Word		x, m;		// operands
+		int		t;		// untruncated result
+	};
+
+	deferred_cc		lazy = {};
+
+	void			defer_cc(Byte width, bool half, Word x, Word m, int t);
+	void			eval_cc();
+	void			eval_deferred_cc();
+
+	bool			flag_c() const;
+	bool			flag_v() const;
+	bool			flag_z() const;
+	bool			flag_n() const;
+
+protected:	// idle loop detection
+	struct loop_state {
+		Word		pc, d, x, y, u, s;
+		Byte		dp, cc;
+		deferred_cc	lazy;
+		uint32_t	side_effects;
+
+		bool		operator==(const loop_state&) const;
+	};
+
+	loop_state		idle_loop = {};
+	Cycles			idle_loop_time = 0;
+	uint64_t		idle_loop_instructions = 0;
+
+	void			check_idle_loop();
+
 private:	// internal processor state
 	bool			waiting_sync;
 	bool			waiting_cwai;
 	bool			nmi_previous;
 
+	Word			no_return_word = 0;	// given out for invalid
+	Byte			no_return_byte = 0;	// register selectors
+
+protected:	// opcode dispatch table
+	struct opcode {
+		void		(mc6809::*handler)();
+		addressing_mode	mode;
+		const char*	mnemonic;
+	};
+
+	static addressing_mode	decode_mode(Word);
+	static const opcode*	opcode_table();
+
+	const opcode*		opcodes;	// pages 0x00, 0x10 and 0x11
+	const opcode*		op;		// current instruction
+
+protected:	// predecoded instruction cache
+	struct decoded {
+		const opcode*	op;		// nullptr if not (yet) valid
+		uint32_t	gen;		// page generation when decoded
+		Word		ir;
+		Word		arg;		// operand bytes following any postbyte
+		Byte		post;
+		Byte		length;		// total instruction bytes
+		Byte		opcode_length;
+	};
+
+	std::vector<decoded>	predecoded;	// empty unless enabled
+	decoded*		recording = nullptr;
+	const decoded*		replaying = nullptr;
+
+	void			execute_predecoded();
+
 private:	// instruction and operand fetch and decode
 	Word&			ix_refreg(Byte);
 
+	void			step();
+	template<typename Done>
+	Cycles			run_while_not(Done done);
 	void			fetch_instruction();
+	Byte			fetch_postbyte();
+	Byte			fetch_operand_byte();
+	Word			fetch_operand_word();
 	Byte			fetch_operand();
 	Word			fetch_word_operand();
 	Word			fetch_effective_address();
@@ -206,11 +288,18 @@ protected: 	// instruction tracing
 	Byte			post;
 	Word			operand;
 
-	std::string		disasm_operand();
-	std::string		disasm_indexed();
+	Disassembler		disasm;
+	Disassembly		traced;		// the instruction being traced
+
+	void			record_regs(TraceRecord&);
+
+protected:	// snapshots
+	virtual void		save_state(StateBuffer& state);
+	virtual void		restore_state(StateReader& state);
 
 public:		// external signal pins
-	InputPin		IRQ, FIRQ, NMI;
+	InputPin		IRQ, FIRQ, NMI;		// polled, if bound
+	InputLine		IRQ_line, FIRQ_line, NMI_line;	// pushed
 
 public:
 					mc6809();		// public constructor
@@ -219,18 +308,123 @@ public:
 	virtual void	reset();		// CPU reset
 	virtual void	tick();
 
+	virtual void	run();
+	virtual Cycles	run_for(Cycles n);
+	virtual Cycles	run_until(Word addr);
+	virtual Cycles	run_until(const std::function<bool()>& done);
+
 	virtual void	print_regs();
 
+	void			predecode_on();
+	void			predecode_off();
+
 	Byte&			byterefreg(int);
 	Word&			wordrefreg(int);
 
 };
 
+//---------------------------------------------------------------------
+//
+// instruction stream fetches, served from the predecoded cache when
+// replaying and remembered in it when recording
+//
+//---------------------------------------------------------------------
+
+inline Byte mc6809::fetch_postbyte()
+{
+	if (replaying) {
+		++cycles;
+		return replaying->post;
+	}
+
+	Byte val = fetch();
+	if (recording) {
+		recording->post = val;
+		++recording->length;
+	}
+	return val;
+}
+
+inline Byte mc6809::fetch_operand_byte()
+{
+	if (replaying) {
+		++cycles;
+		return (Byte)replaying->arg;
+	}
+
+	Byte val = fetch();
+	if (recording) {
+		recording->arg = val;
+		++recording->length;
+	}
+	return val;
+}
+
+inline Word mc6809::fetch_operand_word()
+{
+	if (replaying) {
+		cycles += 2;
+		return replaying->arg;
+	}
+
+	Word val = fetch_word();
+	if (recording) {
+		recording->arg = val;
+		recording->length += 2;
+	}
+	return val;
+}
+
+//---------------------------------------------------------------------
+//
+// lazily evaluated condition codes
+//
+//---------------------------------------------------------------------
+
+inline void mc6809::defer_cc(Byte width, bool half, Word x, Word m, int t)
+{
+	// H survives everything other than 8 bit additions
+	if (lazy.half && !half) {
+		cc.bit.h = btst((Word)(lazy.x ^ lazy.m ^ lazy.t), 4);
+	}
+	lazy = { width, half, x, m, t };
+}
+
+inline void mc6809::eval_cc()
+{
+	if (lazy.width) {
+		eval_deferred_cc();
+	}
+}
+
+inline bool mc6809::flag_c() const
+{
+	return lazy.width ? (lazy.t >> lazy.width) & 1 : cc.bit.c;
+}
+
+inline bool mc6809::flag_v() const
+{
+	return lazy.width ? ((lazy.x ^ lazy.m ^ lazy.t ^ (lazy.t >> 1)) >> (lazy.width - 1)) & 1 : cc.bit.v;
+}
+
+inline bool mc6809::flag_z() const
+{
+	return lazy.width ? !(lazy.t & ((1 << lazy.width) - 1)) : cc.bit.z;
+}
+
+inline bool mc6809::flag_n() const
+{
+	return lazy.width ? (lazy.t >> (lazy.width - 1)) & 1 : cc.bit.n;
+}
+
 inline void mc6809::do_br(const char *mnemonic, bool test)
 {
 	(void)mnemonic;
 	Word offset = extend8(fetch_operand());
-	if (test) pc += offset;
+	if (test) {
+		if (offset & 0x8000) check_idle_loop();
+		pc += offset;
+	}
 	++cycles;
 }
 
@@ -239,6 +433,7 @@ inline void mc6809::do_lbr(const char *mnemonic, bool test)
 	(void)mnemonic;
 	Word offset = fetch_word_operand();
 	if (test) {
+		if (offset & 0x8000) check_idle_loop();
 		pc += offset;
 		++cycles;
 	}
@@ -16,55 +16,24 @@
 void mc6809::help_adc(Byte& x)
 {
 	Byte	m = fetch_operand();
+	int	t = x + m + flag_c();
 
-	{
-		Byte	t = (x & 0x0f) + (m & 0x0f) + cc.bit.c;
-		cc.bit.h = btst(t, 4);		// Half carry
-	}
-
-	{
-		Byte	t = (x & 0x7f) + (m & 0x7f) + cc.bit.c;
-		cc.bit.v = btst(t, 7);		// Bit 7 carry in
-	}
-
-	{
-		Word	t = x + m + cc.bit.c;
-		cc.bit.c = btst(t, 8);		// Bit 7 carry out
-		x = t & 0xff;
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(x, 7);
-	cc.bit.z = !x;
+	defer_cc(8, true, x, m, t);
+	x = t & 0xff;
 }
 
 void mc6809::help_add(Byte& x)
 {
 	Byte	m = fetch_operand();
+	int	t = x + m;
 
-	{
-		Byte	t = (x & 0x0f) + (m & 0x0f);
-		cc.bit.h = btst(t, 4);		// Half carry
-	}
-
-	{
-		Byte	t = (x & 0x7f) + (m & 0x7f);
-		cc.bit.v = btst(t, 7);		// Bit 7 carry in
-	}
-
-	{
-		Word	t = x + m;
-		cc.bit.c = btst(t, 8);		// Bit 7 carry out
-		x = t & 0xff;
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(x, 7);
-	cc.bit.z = !x;
+	defer_cc(8, true, x, m, t);
+	x = t & 0xff;
 }
 
 void mc6809::help_and(Byte& x)
 {
+	eval_cc();
 	x = x & fetch_operand();
 	cc.bit.n = btst(x, 7);
 	cc.bit.z = !x;
@@ -73,6 +42,7 @@ void mc6809::help_and(Byte& x)
 
 void mc6809::help_asr(Byte& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 0);
 	x >>= 1;	/* Shift word right */
 	if ((cc.bit.n = btst(x, 6)) != 0) {
@@ -84,6 +54,7 @@ void mc6809::help_asr(Byte& x)
 
 void mc6809::help_bit(Byte x)
 {
+	eval_cc();
 	Byte t = x & fetch_operand();
 	cc.bit.n = btst(t, 7);
 	cc.bit.v = 0;
@@ -92,6 +63,7 @@ void mc6809::help_bit(Byte x)
 
 void mc6809::help_clr(Byte& x)
 {
+	eval_cc();
 	cc.all &= 0xf0;
 	cc.all |= 0x04;
 	x = 0;
@@ -103,26 +75,21 @@ void mc6809::help_cmp(Byte x)
 	Byte	m = fetch_operand();
 	int	t = x - m;
 
-	cc.bit.v = btst((Byte)(x ^ m ^ t ^ (t >> 1)), 7);
-	cc.bit.c = btst((Word)t, 8);
-	cc.bit.n = btst((Byte)t, 7);
-	cc.bit.z = !(t & 0xff);
+	defer_cc(8, false, x, m, t);
 }
 
 void mc6809::help_cmp(Word x)
 {
 	Word	m = fetch_word_operand();
-	long	t = x - m;
+	int	t = x - m;
 
-	cc.bit.v = btst((DWord)(x ^ m ^ t ^ (t >> 1)), 15);
-	cc.bit.c = btst((DWord)t, 16);
-	cc.bit.n = btst((DWord)t, 15);
-	cc.bit.z = !(t & 0xffff);
+	defer_cc(16, false, x, m, t);
 	++cycles;
 }
 
 void mc6809::help_com(Byte& x)
 {
+	eval_cc();
 	x = ~x;
 	cc.bit.c = 1;
 	cc.bit.v = 0;
@@ -133,6 +100,7 @@ void mc6809::help_com(Byte& x)
 
 void mc6809::help_dec(Byte& x)
 {
+	eval_cc();
 	cc.bit.v = (x == 0x80);
 	x = x - 1;
 	cc.bit.n = btst(x, 7);
@@ -142,6 +110,7 @@ void mc6809::help_dec(Byte& x)
 
 void mc6809::help_eor(Byte& x)
 {
+	eval_cc();
 	x = x ^ fetch_operand();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 7);
@@ -150,6 +119,7 @@ void mc6809::help_eor(Byte& x)
 
 void mc6809::help_inc(Byte& x)
 {
+	eval_cc();
 	cc.bit.v = (x == 0x7f);
 	x = x + 1;
 	cc.bit.n = btst(x, 7);
@@ -159,6 +129,7 @@ void mc6809::help_inc(Byte& x)
 
 void mc6809::help_ld(Byte& x)
 {
+	eval_cc();
 	x = fetch_operand();
 	cc.bit.n = btst(x, 7);
 	cc.bit.v = 0;
@@ -167,6 +138,7 @@ void mc6809::help_ld(Byte& x)
 
 void mc6809::help_ld(Word& x)
 {
+	eval_cc();
 	x = fetch_word_operand();
 	cc.bit.n = btst(x, 15);
 	cc.bit.v = 0;
@@ -175,6 +147,7 @@ void mc6809::help_ld(Word& x)
 
 void mc6809::help_lsl(Byte& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 7);
 	cc.bit.v = btst(x, 7) ^ btst(x, 6);
 	x <<= 1;
@@ -185,6 +158,7 @@ void mc6809::help_lsl(Byte& x)
 
 void mc6809::help_lsr(Byte& x)
 {
+	eval_cc();
 	cc.bit.c = btst(x, 0);
 	x >>= 1;	/* Shift word right */
 	cc.bit.n = 0;
@@ -194,6 +168,7 @@ void mc6809::help_lsr(Byte& x)
 
 void mc6809::help_neg(Byte& x)
 {
+	eval_cc();
 	int	t = 0 - x;
 
 	cc.bit.v = btst((Byte)(x ^ t ^ (t >> 1)), 7);
@@ -206,6 +181,7 @@ void mc6809::help_neg(Byte& x)
 
 void mc6809::help_or(Byte& x)
 {
+	eval_cc();
 	x = x | fetch_operand();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 7);
@@ -214,6 +190,7 @@ void mc6809::help_or(Byte& x)
 
 void mc6809::help_psh(Byte w, Word& s, Word& u)
 {
+	eval_cc();
 	if (btst(w, 7)) do_psh(s, pc);
 	if (btst(w, 6)) do_psh(s, u);
 	if (btst(w, 5)) do_psh(s, y);
@@ -226,6 +203,7 @@ void mc6809::help_psh(Byte w, Word& s, Word& u)
 
 void mc6809::help_pul(Byte w, Word& s, Word& u)
 {
+	eval_cc();
 	if (btst(w, 0)) do_pul(s, cc.all);
 	if (btst(w, 1)) do_pul(s, a);
 	if (btst(w, 2)) do_pul(s, b);
@@ -238,6 +216,7 @@ void mc6809::help_pul(Byte w, Word& s, Word& u)
 
 void mc6809::help_rol(Byte& x)
 {
+	eval_cc();
 	int	oc = cc.bit.c;
 	cc.bit.v = btst(x, 7) ^ btst(x, 6);
 	cc.bit.c = btst(x, 7);
@@ -250,6 +229,7 @@ void mc6809::help_rol(Byte& x)
 
 void mc6809::help_ror(Byte& x)
 {
+	eval_cc();
 	int	oc = cc.bit.c;
 	cc.bit.c = btst(x, 0);
 	x = x >> 1;
@@ -261,18 +241,16 @@ void mc6809::help_ror(Byte& x)
 
 void mc6809::help_sbc(Byte& x)
 {
-	Byte    m = fetch_operand();
-	int t = x - m - cc.bit.c;
+	Byte	m = fetch_operand();
+	int	t = x - m - flag_c();
 
-	cc.bit.v = btst((Byte)(x ^ m ^ t ^ (t >> 1)), 7);
-	cc.bit.c = btst((Word)t, 8);
-	cc.bit.n = btst((Byte)t, 7);
+	defer_cc(8, false, x, m, t);
 	x = t & 0xff;
-	cc.bit.z = !x;
 }
 
 void mc6809::help_st(Byte x)
 {
+	eval_cc();
 	Word	addr = fetch_effective_address();
 	write(addr, x);
 	cc.bit.v = 0;
@@ -282,6 +260,7 @@ void mc6809::help_st(Byte x)
 
 void mc6809::help_st(Word x)
 {
+	eval_cc();
 	Word	addr = fetch_effective_address();
 	write_word(addr, x);
 	cc.bit.v = 0;
@@ -291,18 +270,16 @@ void mc6809::help_st(Word x)
 
 void mc6809::help_sub(Byte& x)
 {
-	Byte    m = fetch_operand();
-	int t = x - m;
+	Byte	m = fetch_operand();
+	int	t = x - m;
 
-	cc.bit.v = btst((Byte)(x^m^t^(t>>1)),7);
-	cc.bit.c = btst((Word)t,8);
-	cc.bit.n = btst((Byte)t, 7);
+	defer_cc(8, false, x, m, t);
 	x = t & 0xff;
-	cc.bit.z = !x;
 }
 
 void mc6809::help_tst(Byte x)
 {
+	eval_cc();
 	cc.bit.v = 0;
 	cc.bit.n = btst(x, 7);
 	cc.bit.z = !x;
@@ -313,91 +290,69 @@ void mc6809::help_tst(Byte x)
 
 void mc6809::abx()
 {
-	insn = "ABX";
 	x += b;
 	++cycles;
 }
 
 void mc6809::adca()
 {
-	insn = "ADCA";
 	help_adc(a);
 }
 
 void mc6809::adcb()
 {
-	insn = "ADCB";
 	help_adc(b);
 }
 
 void mc6809::adda()
 {
-	insn = "ADDA";
 	help_add(a);
 }
 
 void mc6809::addb()
 {
-	insn = "ADDB";
 	help_add(b);
 }
 
 void mc6809::addd()
 {
-	insn = "ADDD";
 	Word	m = fetch_word_operand();
+	int	t = d + m;
 
-	{
-		Word	t = (d & 0x7fff) + (m & 0x7fff);
-		cc.bit.v = btst(t, 15);
-	}
-
-	{
-		DWord	t = (DWord)d + m;
-		cc.bit.c = btst(t, 16);
-		d = (Word)(t & 0xffff);
-	}
-
-	cc.bit.v ^= cc.bit.c;
-	cc.bit.n = btst(d, 15);
-	cc.bit.z = !d;
+	defer_cc(16, false, d, m, t);
+	d = t & 0xffff;
 	++cycles;
 }
 
 void mc6809::anda()
 {
-	insn = "ANDA";
 	help_and(a);
 }
 
 void mc6809::andb()
 {
-	insn = "ANDB";
 	help_and(b);
 }
 
 void mc6809::andcc()
 {
-	insn = "ANDCC";
+	eval_cc();
 	cc.all &= fetch_operand();
 	++cycles;
 }
 
 void mc6809::asra()
 {
-	insn = "ASRA";
 	help_asr(a);
 }
 
 void mc6809::asrb()
 {
-	insn = "ASRB";
 	help_asr(b);
 }
 
 void mc6809::asr()
 {
-	insn = "ASR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 
@@ -407,241 +362,204 @@ void mc6809::asr()
 
 void mc6809::bcc()
 {
-	insn = "BCC";
-	do_br("cc", !cc.bit.c);
+	do_br("cc", !flag_c());
 }
 
 void mc6809::lbcc()
 {
-	insn = "LBCC";
-	do_lbr("cc", !cc.bit.c);
+	do_lbr("cc", !flag_c());
 }
 
 void mc6809::bcs()
 {
-	insn = "BCS";
-	do_br("cs", cc.bit.c);
+	do_br("cs", flag_c());
 }
 
 void mc6809::lbcs()
 {
-	insn = "LBCS";
-	do_lbr("cs", cc.bit.c);
+	do_lbr("cs", flag_c());
 }
 
 void mc6809::beq()
 {
-	insn = "BEQ";
-	do_br("eq", cc.bit.z);
+	do_br("eq", flag_z());
 }
 
 void mc6809::lbeq()
 {
-	insn = "LBEQ";
-	do_lbr("eq", cc.bit.z);
+	do_lbr("eq", flag_z());
 }
 
 void mc6809::bge()
 {
-	insn = "BGE";
-	do_br("ge", !(cc.bit.n ^ cc.bit.v));
+	do_br("ge", !(flag_n() ^ flag_v()));
 }
 
 void mc6809::lbge()
 {
-	insn = "LGBE";
-	do_lbr("ge", !(cc.bit.n ^ cc.bit.v));
+	do_lbr("ge", !(flag_n() ^ flag_v()));
 }
 
 void mc6809::bgt()
 {
-	insn = "BGT";
-	do_br("gt", !(cc.bit.z | (cc.bit.n ^ cc.bit.v)));
+	do_br("gt", !(flag_z() | (flag_n() ^ flag_v())));
 }
 
 void mc6809::lbgt()
 {
-	insn = "LBGT";
-	do_lbr("gt", !(cc.bit.z | (cc.bit.n ^ cc.bit.v)));
+	do_lbr("gt", !(flag_z() | (flag_n() ^ flag_v())));
 }
 
 void mc6809::bhi()
 {
-	insn = "BHI";
-	do_br("hi", !(cc.bit.c | cc.bit.z));
+	do_br("hi", !(flag_c() | flag_z()));
 }
 
 void mc6809::lbhi()
 {
-	insn = "LBHI";
-	do_lbr("hi", !(cc.bit.c | cc.bit.z));
+	do_lbr("hi", !(flag_c() | flag_z()));
 }
 
 void mc6809::bita()
 {
-	insn = "BITA";
 	help_bit(a);
 }
 
 void mc6809::bitb()
 {
-	insn = "BITB";
 	help_bit(b);
 }
 
 void mc6809::ble()
 {
-	insn = "BLE";
-	do_br("le", cc.bit.z | (cc.bit.n ^ cc.bit.v));
+	do_br("le", flag_z() | (flag_n() ^ flag_v()));
 }
 
 void mc6809::lble()
 {
-	insn = "LBLE";
-	do_lbr("le", cc.bit.z | (cc.bit.n ^ cc.bit.v));
+	do_lbr("le", flag_z() | (flag_n() ^ flag_v()));
 }
 
 void mc6809::bls()
 {
-	insn = "BLS";
-	do_br("ls", cc.bit.c | cc.bit.z);
+	do_br("ls", flag_c() | flag_z());
 }
 
 void mc6809::lbls()
 {
-	insn = "LBLS";
-	do_lbr("ls", cc.bit.c | cc.bit.z);
+	do_lbr("ls", flag_c() | flag_z());
 }
 
 void mc6809::blt()
 {
-	insn = "BLT";
-	do_br("lt", cc.bit.n ^ cc.bit.v);
+	do_br("lt", flag_n() ^ flag_v());
 }
 
 void mc6809::lblt()
 {
-	insn = "LBLT";
-	do_lbr("lt", cc.bit.n ^ cc.bit.v);
+	do_lbr("lt", flag_n() ^ flag_v());
 }
 
 void mc6809::bmi()
 {
-	insn = "BMI";
-	do_br("mi", cc.bit.n);
+	do_br("mi", flag_n());
 }
 
 void mc6809::lbmi()
 {
-	insn = "LBMI";
-	do_lbr("mi", cc.bit.n);
+	do_lbr("mi", flag_n());
 }
 
 void mc6809::bne()
 {
-	insn = "BNE";
-	do_br("ne", !cc.bit.z);
+	do_br("ne", !flag_z());
 }
 
 void mc6809::lbne()
 {
-	insn = "LBNE";
-	do_lbr("ne", !cc.bit.z);
+	do_lbr("ne", !flag_z());
 }
 
 void mc6809::bpl()
 {
-	insn = "BPL";
-	do_br("pl", !cc.bit.n);
+	do_br("pl", !flag_n());
 }
 
 void mc6809::lbpl()
 {
-	insn = "LBPL";
-	do_lbr("pl", !cc.bit.n);
+	do_lbr("pl", !flag_n());
 }
 
 void mc6809::bra()
 {
-	insn = "BRA";
 	do_br("ra", 1);
 }
 
 void mc6809::lbra()
 {
-	insn = "LBRA";
 	do_lbr("ra", 1);
 }
 
 void mc6809::brn()
 {
-	insn = "BRN";
 	do_br("rn", 0);
 }
 
 void mc6809::lbrn()
 {
-	insn = "LBRN";
 	do_lbr("rn", 0);
 }
 
 void mc6809::bsr()
 {
-	insn = "BSR";
 	Byte	x = fetch_operand();
 	do_psh(s, pc);
 	pc += extend8(x);
 	cycles += 3;
+	profile_call(s);
 }
 
 void mc6809::lbsr()
 {
-	insn = "LBSR";
 	Word	x = fetch_word_operand();
 	do_psh(s, pc);
 	pc += x;
 	cycles += 4;
+	profile_call(s);
 }
 
 void mc6809::bvc()
 {
-	insn = "BVC";
-	do_br("vc", !cc.bit.v);
+	do_br("vc", !flag_v());
 }
 
 void mc6809::lbvc()
 {
-	insn = "LBVC";
-	do_lbr("vc", !cc.bit.v);
+	do_lbr("vc", !flag_v());
 }
 
 void mc6809::bvs()
 {
-	insn = "BVS";
-	do_br("vs", cc.bit.v);
+	do_br("vs", flag_v());
 }
 
 void mc6809::lbvs()
 {
-	insn = "LBVS";
-	do_lbr("vs", cc.bit.v);
+	do_lbr("vs", flag_v());
 }
 
 void mc6809::clra()
 {
-	insn = "CLRA";
 	help_clr(a);
 }
 
 void mc6809::clrb()
 {
-	insn = "CLRB";
 	help_clr(b);
 }
 
 void mc6809::clr()
 {
-	insn = "CLR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_clr(m);
@@ -650,49 +568,42 @@ void mc6809::clr()
 
 void mc6809::cmpa()
 {
-	insn = "CMPA";
 	help_cmp(a);
 }
 
 void mc6809::cmpb()
 {
-	insn = "CMPB";
 	help_cmp(b);
 }
 
 void mc6809::cmpd()
 {
-	insn = "CMPD";
 	help_cmp(d);
 }
 
 void mc6809::cmpx()
 {
-	insn = "CMPX";
 	help_cmp(x);
 }
 
 void mc6809::cmpy()
 {
-	insn = "CMPY";
 	help_cmp(y);
 }
 
 void mc6809::cmpu()
 {
-	insn = "CMPU";
 	help_cmp(u);
 }
 
 void mc6809::cmps()
 {
-	insn = "CMPS";
 	help_cmp(s);
 }
 
 void mc6809::cwai()
 {
-	insn = "CWAI";
+	eval_cc();
 	Byte	n = fetch_operand();
 	cc.all &= n;
 	cc.bit.e = 1;
@@ -703,19 +614,16 @@ void mc6809::cwai()
 
 void mc6809::coma()
 {
-	insn = "COMA";
 	help_com(a);
 }
 
 void mc6809::comb()
 {
-	insn = "COMB";
 	help_com(b);
 }
 
 void mc6809::com()
 {
-	insn = "COM";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_com(m);
@@ -724,7 +632,7 @@ void mc6809::com()
 
 void mc6809::daa()
 {
-	insn = "DAA";
+	eval_cc();
 	Byte	c = 0;
 	Byte	lsn = (a & 0x0f);
 	Byte	msn = (a & 0xf0) >> 4;
@@ -752,19 +660,16 @@ void mc6809::daa()
 
 void mc6809::deca()
 {
-	insn = "DECA";
 	help_dec(a);
 }
 
 void mc6809::decb()
 {
-	insn = "DECB";
 	help_dec(b);
 }
 
 void mc6809::dec()
 {
-	insn = "DEC";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_dec(m);
@@ -773,19 +678,16 @@ void mc6809::dec()
 
 void mc6809::eora()
 {
-	insn = "EORA";
 	help_eor(a);
 }
 
 void mc6809::eorb()
 {
-	insn = "EORB";
 	help_eor(b);
 }
 
 void mc6809::exg()
 {
-	insn = "EXG";
 	Byte w = fetch_operand();
 	int r1 = (w & 0xf0) >> 4;
 	int r2 = (w & 0x0f) >> 0;
@@ -803,19 +705,16 @@ void mc6809::exg()
 
 void mc6809::inca()
 {
-	insn = "INCA";
 	help_inc(a);
 }
 
 void mc6809::incb()
 {
-	insn = "INCB";
 	help_inc(b);
 }
 
 void mc6809::inc()
 {
-	insn = "INC";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_inc(m);
@@ -824,64 +723,56 @@ void mc6809::inc()
 
 void mc6809::jmp()
 {
-	insn = "JMP";
 	pc = fetch_effective_address();
 }
 
 void mc6809::jsr()
 {
-	insn = "JSR";
 	Word	addr = fetch_effective_address();
 	do_psh(s, pc);
 	pc = addr;
 	cycles += 2;
+	profile_call(s);
 }
 
 void mc6809::lda()
 {
-	insn = "LDA";
 	help_ld(a);
 }
 
 void mc6809::ldb()
 {
-	insn = "LDB";
 	help_ld(b);
 }
 
 void mc6809::ldd()
 {
-	insn = "LDD";
 	help_ld(d);
 }
 
 void mc6809::ldx()
 {
-	insn = "LDX";
 	help_ld(x);
 }
 
 void mc6809::ldy()
 {
-	insn = "LDY";
 	help_ld(y);
 }
 
 void mc6809::lds()
 {
-	insn = "LDS";
 	help_ld(s);
 }
 
 void mc6809::ldu()
 {
-	insn = "LDU";
 	help_ld(u);
 }
 
 void mc6809::leax()
 {
-	insn = "LEAX";
+	eval_cc();
 	x = fetch_effective_address();
 	cc.bit.z = !x;
 	++cycles;
@@ -889,7 +780,7 @@ void mc6809::leax()
 
 void mc6809::leay()
 {
-	insn = "LEAY";
+	eval_cc();
 	y = fetch_effective_address();
 	cc.bit.z = !y;
 	++cycles;
@@ -897,33 +788,28 @@ void mc6809::leay()
 
 void mc6809::leas()
 {
-	insn = "LEAS";
 	s = fetch_effective_address();
 	++cycles;
 }
 
 void mc6809::leau()
 {
-	insn = "LEAU";
 	u = fetch_effective_address();
 	++cycles;
 }
 
 void mc6809::lsla()
 {
-	insn = "LSLA";
 	help_lsl(a);
 }
 
 void mc6809::lslb()
 {
-	insn = "LSLB";
 	help_lsl(b);
 }
 
 void mc6809::lsl()
 {
-	insn = "LSL";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_lsl(m);
@@ -932,19 +818,16 @@ void mc6809::lsl()
 
 void mc6809::lsra()
 {
-	insn = "LSRA";
 	help_lsr(a);
 }
 
 void mc6809::lsrb()
 {
-	insn = "LSRB";
 	help_lsr(b);
 }
 
 void mc6809::lsr()
 {
-	insn = "LSR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_lsr(m);
@@ -953,7 +836,7 @@ void mc6809::lsr()
 
 void mc6809::mul()
 {
-	insn = "MUL";
+	eval_cc();
 	d = a * b;
 	cc.bit.c = btst(b, 7);
 	cc.bit.z = !d;
@@ -962,19 +845,16 @@ void mc6809::mul()
 
 void mc6809::nega()
 {
-	insn = "NEGA";
 	help_neg(a);
 }
 
 void mc6809::negb()
 {
-	insn = "NEGB";
 	help_neg(b);
 }
 
 void mc6809::neg()
 {
-	insn = "NEG";
 	Word 	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_neg(m);
@@ -983,32 +863,28 @@ void mc6809::neg()
 
 void mc6809::nop()
 {
-	insn = "NOP";
 	++cycles;
 }
 
 void mc6809::ora()
 {
-	insn = "ORA";
 	help_or(a);
 }
 
 void mc6809::orb()
 {
-	insn = "ORB";
 	help_or(b);
 }
 
 void mc6809::orcc()
 {
-	insn = "ORCC";
+	eval_cc();
 	cc.all |= fetch_operand();
 	++cycles;
 }
 
 void mc6809::pshs()
 {
-	insn = "PSHS";
 	Byte w = fetch_operand();
 	help_psh(w, s, u);
 	cycles += 3;
@@ -1016,7 +892,6 @@ void mc6809::pshs()
 
 void mc6809::pshu()
 {
-	insn = "PSHU";
 	Byte w = fetch_operand();
 	help_psh(w, u, s);
 	cycles += 3;
@@ -1024,7 +899,6 @@ void mc6809::pshu()
 
 void mc6809::puls()
 {
-	insn = "PULS";
 	Byte w = fetch_operand();
 	help_pul(w, s, u);
 	cycles += 3;
@@ -1032,7 +906,6 @@ void mc6809::puls()
 
 void mc6809::pulu()
 {
-	insn = "PULU";
 	Byte w = fetch_operand();
 	help_pul(w, u, s);
 	cycles += 3;
@@ -1040,19 +913,16 @@ void mc6809::pulu()
 
 void mc6809::rola()
 {
-	insn = "ROLA";
 	help_rol(a);
 }
 
 void mc6809::rolb()
 {
-	insn = "ROLB";
 	help_rol(b);
 }
 
 void mc6809::rol()
 {
-	insn = "ROL";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_rol(m);
@@ -1061,19 +931,16 @@ void mc6809::rol()
 
 void mc6809::rora()
 {
-	insn = "RORA";
 	help_ror(a);
 }
 
 void mc6809::rorb()
 {
-	insn = "RORB";
 	help_ror(b);
 }
 
 void mc6809::ror()
 {
-	insn = "ROR";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_ror(m);
@@ -1082,7 +949,6 @@ void mc6809::ror()
 
 void mc6809::rti()
 {
-	insn = "RTI";
 	help_pul(0x01, s, u);
 	if (cc.bit.e) {
 		help_pul(0xfe, s, u);
@@ -1090,30 +956,29 @@ void mc6809::rti()
 		help_pul(0x80, s, u);
 	}
 	cycles += 2;
+	profile_return(s);
 }
 
 void mc6809::rts()
 {
-	insn = "RTS";
 	do_pul(s, pc);
 	cycles += 2;
+	profile_return(s);
 }
 
 void mc6809::sbca()
 {
-	insn = "SBCA";
 	help_sbc(a);
 }
 
 void mc6809::sbcb()
 {
-	insn = "SBCB";
 	help_sbc(b);
 }
 
 void mc6809::sex()
 {
-	insn = "SEX";
+	eval_cc();
 	cc.bit.n = btst(b, 7);
 	cc.bit.z = !b;
 	a = cc.bit.n ? 255 : 0;
@@ -1122,109 +987,94 @@ void mc6809::sex()
 
 void mc6809::sta()
 {
-	insn = "STA";
 	help_st(a);
 }
 
 void mc6809::stb()
 {
-	insn = "STB";
 	help_st(b);
 }
 
 void mc6809::std()
 {
-	insn = "STD";
 	help_st(d);
 }
 
 void mc6809::stx()
 {
-	insn = "STX";
 	help_st(x);
 }
 
 void mc6809::sty()
 {
-	insn = "STY";
 	help_st(y);
 }
 
 void mc6809::sts()
 {
-	insn = "STS";
 	help_st(s);
 }
 
 void mc6809::stu()
 {
-	insn = "STU";
 	help_st(u);
 }
 
 void mc6809::suba()
 {
-	insn = "SUBA";
 	help_sub(a);
 }
 
 void mc6809::subb()
 {
-	insn = "SUBB";
 	help_sub(b);
 }
 
 void mc6809::subd()
 {
-	insn = "SUBD";
-	Word    m = fetch_word_operand();
-	int t = d - m;
+	Word	m = fetch_word_operand();
+	int	t = d - m;
 
-	cc.bit.v = btst((DWord)(d ^ m ^ t ^(t >> 1)), 15);
-	cc.bit.c = btst((DWord)t, 16);
-	cc.bit.n = btst((DWord)t, 15);
+	defer_cc(16, false, d, m, t);
 	d = t & 0xffff;
-	cc.bit.z = !d;
 }
 
 void mc6809::swi()
 {
-	insn = "SWI";
 	cc.bit.e = 1;
 	help_psh(0xff, s, u);
 	cc.bit.f = cc.bit.i = 1;
 	pc = read_word(0xfffa);
 	cycles += 4;
+	profile_call(s);
 }
 
 void mc6809::swi2()
 {
-	insn = "SWI2";
 	cc.bit.e = 1;
 	help_psh(0xff, s, u);
 	pc = read_word(0xfff4);
 	cycles += 4;
+	profile_call(s);
 }
 
 void mc6809::swi3()
 {
-	insn = "SWI3";
 	cc.bit.e = 1;
 	help_psh(0xff, s, u);
 	pc = read_word(0xfff2);
 	cycles += 4;
+	profile_call(s);
 }
 
 void mc6809::sync()
 {
-	insn = "SYNC";
 	waiting_sync = true;
 	++cycles;
 }
 
 void mc6809::tfr()
 {
-	insn = "TFR";
 	Byte	w = fetch_operand();
 	int r1 = (w & 0xf0) >> 4;
 	int r2 = (w & 0x0f) >> 0;
@@ -1242,19 +1092,16 @@ void mc6809::tfr()
 
 void mc6809::tsta()
 {
-	insn = "TSTA";
 	help_tst(a);
 }
 
 void mc6809::tstb()
 {
-	insn = "TSTB";
 	help_tst(b);
 }
 
 void mc6809::tst()
 {
-	insn = "TST";
 	Word	addr = fetch_effective_address();
 	Byte	m = read(addr);
 	help_tst(m);
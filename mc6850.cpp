@@ -5,6 +5,7 @@
 //	(C) R.P.Bellis 1994
 //
 
+#include <algorithm>
 #include "mc6850.h"
 #include "bits.h"
 
@@ -24,25 +25,66 @@ void mc6850::reset()
 {
 	cr = 0;		// Clear all control flags
 	sr = TDRE;	// Clear all status bits except TDRE
-	cycles = 0;
+	tx_busy = false;
+	rx_ready = now();
+	injecting = false;
+	update_irq();
+	wake_at(now() + interval);
 }
 
-void mc6850::tick(uint8_t ticks)
+void mc6850::set_baud_clock(double cpu_hz, double acia_hz)
 {
-	if ((sr & IRQB) == 0) {
-		if (((sr & TDRE) && ((cr & 0x60) == 0x20)) ||
-			((sr & RDRF) && ((cr & 0x80) == 0x80)))
-		{
-			sr |= IRQB;
-		}
+	mode = timed;
+	cycles_per_clock = cpu_hz / acia_hz;
+}
+
+void mc6850::set_turbo()
+{
+	mode = turbo;
+}
+
+// Start bit, data, parity and stop bits, by CR4-CR2
+static const Byte frame_bits[8] = { 11, 11, 10, 10, 11, 10, 11, 11 };
+
+// By CR1-CR0, the last being master reset
+static const Byte clock_divide[4] = { 1, 16, 64, 1 };
+
+Cycles mc6850::char_cycles() const
+{
+	Cycles n = frame_bits[(cr >> 2) & 7] * clock_divide[cr & 3] * cycles_per_clock + 0.5;
+	return n ? n : 1;
+}
+
+// Raise IRQB if an enabled interrupt condition is present,
+// and drive ~IRQ to match
+void mc6850::update_irq()
+{
+	if (((sr & TDRE) && ((cr & 0x60) == 0x20)) ||
+		((sr & RDRF) && ((cr & 0x80) == 0x80)))
+	{
+		sr |= IRQB;
 	}
+	IRQ_line.set(!(sr & IRQB));
+}
 
-	cycles += ticks;
-	if (cycles < interval) return;
-	cycles = 0;
+void mc6850::tick(Cycles now)
+{
+	if (mode == timed) {
+		tick_timed(now);
+	} else {
+		tick_polled(now);
+	}
+}
+
+// Turbo mode moves characters as soon as the guest reads or writes
+// them, leaving this to pick up input that arrives in between, as
+// does injected input, other than for a delay after each line
+void mc6850::tick_polled(Cycles now)
+{
+	wake_at(now < rx_ready ? std::min(now + interval, rx_ready) : now + interval);
 
 	// Check for a received character if one isn't available
-	if ((sr & RDRF) == 0) {
+	if ((sr & RDRF) == 0 && now >= rx_ready) {
 		// If input is ready read a character
 		if (impl.poll_read()) {
 			rd = impl.read();
@@ -54,6 +96,73 @@ void mc6850::tick(uint8_t ticks)
 		impl.write(td);
 		sr |= TDRE;
 	}
+
+	impl.tick();
+	update_irq();
+}
+
+// Takes a character from the real device if one has had time to
+// arrive, or else looks again a character time later, but no sooner
+// than the next poll, so as not to hammer a device that has none
+void mc6850::receive(Cycles now)
+{
+	if ((sr & RDRF) || now < rx_ready) {
+		return;
+	}
+
+	if (impl.poll_read()) {
+		rd = impl.read();
+		sr |= RDRF;
+		rx_ready = now + char_cycles();
+	} else {
+		rx_ready = now + std::max<Cycles>(char_cycles(), interval);
+	}
+}
+
+// Each character is delivered when its last stop bit would have
+// been sent, with the next one moving from the data register into
+// the shift register at that moment
+void mc6850::tick_timed(Cycles now)
+{
+	if (tx_busy && now >= tx_done) {
+		impl.write(tx_shift);
+		if ((sr & TDRE) == 0) {
+			tx_shift = td;
+			sr |= TDRE;
+			tx_done += char_cycles();
+		} else {
+			tx_busy = false;
+		}
+	}
+
+	receive(now);
+	impl.tick();
+	update_irq();
+
+	// still tick every interval, for the impl's sake
+	Cycles next = now + interval;
+	if (tx_busy) {
+		next = std::min(next, tx_done);
+	}
+	if ((sr & RDRF) == 0) {
+		next = std::min(next, rx_ready);
+	}
+	wake_at(next);
+}
+
+// Nothing to do until the next poll, so if all output has been
+// sent wait there for some input
+void mc6850::idle()
+{
+	if ((sr & (RDRF | TDRE)) == TDRE) {
+		impl.wait_read();
+	}
+}
+
+// Only reading the data register changes anything
+bool mc6850::read_is_passive(Word offset)
+{
+	return (offset & 1) == 0;
 }
 
 Byte mc6850::read(Word offset)
@@ -63,10 +172,30 @@ Byte mc6850::read(Word offset)
 			return sr;
 			break;
 		case 1:	// read data
-		default:
+		default: {
+			Byte data = rd;
+			Cycles delay = 0;
+			bool paced = impl.next_read_delay(delay);
+
+			// the guest's echo of injected input needn't wait either
+			injecting = paced;
+
 			sr &= ~(RDRF | IRQB);
-			return rd;
+			if ((paced || mode == turbo) && delay == 0) {
+				if (impl.poll_read()) {
+					rd = impl.read();
+					sr |= RDRF;
+				}
+			} else if (paced) {
+				rx_ready = now() + delay;
+				wake_at(std::min(wakeup, rx_ready));
+			} else if (mode == timed) {
+				wake_at(std::min(wakeup, std::max(now(), rx_ready)));
+			}
+			update_irq();
+			return data;
 			break;
+		}
 	}
 }
 
@@ -78,10 +207,52 @@ void mc6850::write(Word offset, Byte val)
 			if ((cr & 0x03) == 0x03) {
 				reset();
 			}
+			update_irq();
 			break;
 		case 1:	// data register
-			td = val;
-			sr &= ~(IRQB | TDRE);
+			if (mode == turbo || (mode == polled && injecting)) {
+				impl.write(val);
+				sr &= ~IRQB;
+			} else if (mode == timed && !tx_busy) {
+				tx_shift = val;
+				tx_busy = true;
+				tx_done = now() + char_cycles();
+				sr &= ~IRQB;
+				wake_at(std::min(wakeup, tx_done));
+			} else {
+				td = val;
+				sr &= ~(IRQB | TDRE);
+			}
+			update_irq();
 			break;
 	}
 }
+
+// The registers only: anything already taken from or given to
+// the real IO device stays that way
+void mc6850::save(StateBuffer& state) const
+{
+	state.put(td);
+	state.put(rd);
+	state.put(cr);
+	state.put(sr);
+	state.put(tx_shift);
+	state.put(tx_busy);
+	state.put(tx_done);
+	state.put(rx_ready);
+	state.put(injecting);
+}
+
+void mc6850::restore(StateReader& state)
+{
+	state.get(td);
+	state.get(rd);
+	state.get(cr);
+	state.get(sr);
+	state.get(tx_shift);
+	state.get(tx_busy);
+	state.get(tx_done);
+	state.get(rx_ready);
+	state.get(injecting);
+	update_irq();
+}
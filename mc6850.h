@@ -16,6 +16,17 @@ public:
 	virtual bool		poll_read() = 0;
 	virtual bool		poll_write() { return true; };
 
+	// block until poll_read() would succeed, if that makes sense
+	virtual void		wait_read() {};
+
+	// called on every poll, whether or not anything was read or written
+	virtual void		tick() {};
+
+	// true if input is being injected in bulk, the next byte to be
+	// polled for `delay` cycles after the guest has read this one,
+	// rather than waiting for the next poll
+	virtual bool		next_read_delay(Cycles& delay) { (void)delay; return false; };
+
 public:
 	virtual Byte		read() = 0;
 	virtual void		write(Byte) = 0;
@@ -47,23 +58,57 @@ protected:
 // Access to real IO device
 	mc6850_impl&		impl;
 	uint16_t			interval;	// how often to poll
-	uint16_t			cycles;		// cycles since last poll
+
+// Character timing: either polled every `interval` cycles, moving
+// at most a byte each way, or each character taking as long as the
+// divide ratio and word format in `cr` say at the ACIA's clock rate,
+// or in turbo mode taking no time at all
+	enum timing_mode : Byte { polled, timed, turbo };
+
+	timing_mode			mode = polled;
+	double				cycles_per_clock = 0;
+
+	Byte				tx_shift;			// being transmitted
+	bool				tx_busy = false;
+	Cycles				tx_done = 0;		// when it will have been
+	Cycles				rx_ready = 0;		// when the next can have arrived
+	bool				injecting = false;	// see mc6850_impl::next_read_delay()
+
+	Cycles				char_cycles() const;
+	void				receive(Cycles now);
 
 // Initialisation functions
 
 protected:
-	virtual void		tick(uint8_t);
+	virtual void		tick(Cycles);
 	virtual void		reset();
+	virtual void		idle();
+
+	void				update_irq();
+	void				tick_polled(Cycles);
+	void				tick_timed(Cycles);
 
 // Read and write functions
 public:
 
 	virtual Byte		read(Word offset);
 	virtual void		write(Word offset, Byte val);
+	virtual bool		read_is_passive(Word offset);
+
+// Snapshots
+public:
+	virtual void		save(StateBuffer& state) const;
+	virtual void		restore(StateReader& state);
 
 // Other exposed interfaces
 public:
 	OutputPinReg		IRQ;
+	OutputLine			IRQ_line;
+
+	// time characters by the ACIA's clock, in Hz, relative to the
+	// CPU's; turbo ignores both and moves them as fast as they go
+	void				set_baud_clock(double cpu_hz, double acia_hz);
+	void				set_turbo();
 
 // Public constructor and destructor
 
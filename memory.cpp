@@ -49,51 +49,51 @@ Word fread_hex_word(FILE *fp)
 
 void ROM::load(const char *filename, Word base)
 {
-	char *c = strrchr((char *)filename, '.');
-
-	if (c == NULL) {
-		FILE *fp = fopen(filename, "r");
-		Byte c;
+	if (!try_load(filename, base)) {
+		exit(EXIT_FAILURE);
+	}
+}
 
-		if (!fp) {
-			perror("filename");
-			exit(EXIT_FAILURE);
-		}
+// Returns false, having said why, if the file can't be read or its
+// format can't be told from its extension or (for Intel hex) its
+// first character
+bool ROM::try_load(const char *filename, Word base)
+{
+	const char *c = strrchr(filename, '.');
 
-		c = fgetc(fp);
-		fclose(fp);
+	if (c != NULL && strcasecmp(c, ".ihex") == 0) {
+		return load_intelhex(filename, base);
+	}
+	if (c != NULL && strcasecmp(c, ".decb") == 0) {
+		return load_decb(filename, base);
+	}
 
-		if (c == ':') {	// Assume Intel Hex		
-			load_intelhex(filename, base);
-		}
-		else {
-			fprintf(stderr, "Can't determine file format of \"%s\"\n", filename);
-			exit(EXIT_FAILURE);
-		}
+	FILE *fp = fopen(filename, "r");
+	if (!fp) {
+		perror(filename);
+		return false;
 	}
-	else {
-		if (strcasecmp(c, ".ihex") == 0) {
-			load_intelhex(filename, base);
-		}
-		else if (strcasecmp(c, ".decb") == 0) {
-			load_decb(filename, base);
-		}
-		else {
-			fprintf(stderr, "Can't determine file format of \"%s\"\n", filename);
-			exit(EXIT_FAILURE);
-		}
+
+	int first = fgetc(fp);
+	fclose(fp);
+
+	if (first == ':') {	// Assume Intel Hex
+		return load_intelhex(filename, base);
 	}
+
+	fprintf(stderr, "Can't determine file format of \"%s\"\n", filename);
+	return false;
 }
 
-void ROM::load_intelhex(const char *filename, Word base)
+bool ROM::load_intelhex(const char *filename, Word base)
 {
 	FILE		*fp;
 	int		done = 0;
 
 	fp = fopen(filename, "r");
 	if (!fp) {
-		perror("filename");
-		exit(EXIT_FAILURE);
+		perror(filename);
+		return false;
 	}
 
 	while (!done) {
@@ -101,7 +101,12 @@ void ROM::load_intelhex(const char *filename, Word base)
 		Word		addr;
 		Byte		b;
 
-		(void)fgetc(fp);
+		// the file ended without an end of file record
+		if (fgetc(fp) == EOF) {
+			fprintf(stderr, "\"%s\" is truncated\n", filename);
+			fclose(fp);
+			return false;
+		}
 		n = fread_hex_byte(fp);
 		addr = fread_hex_word(fp);
 		t = fread_hex_byte(fp);
@@ -120,17 +125,20 @@ void ROM::load_intelhex(const char *filename, Word base)
 		(void)fread_hex_byte(fp);
 		if (fgetc(fp) == '\r') (void)fgetc(fp);
 	}
+
+	fclose(fp);
+	return true;
 }
 
-void ROM::load_decb(const char *filename, Word base)
+bool ROM::load_decb(const char *filename, Word base)
 {
 	FILE		*fp;
 	int		done = 0;
 
 	fp = fopen(filename, "r");
 	if (!fp) {
-		perror("filename");
-		exit(EXIT_FAILURE);
+		perror(filename);
+		return false;
 	}
 
 	while (!done) {
@@ -154,12 +162,16 @@ void ROM::load_decb(const char *filename, Word base)
 			}
 		}
 		else if (hdr == 0xff) {
-			// End of data marker
-			return;
+			// End of data marker, or the end of the file
+			fclose(fp);
+			return true;
 		}
 		else {
 			// shouldn't happen
 			;
 		}
 	}
+
+	fclose(fp);
+	return true;
 }
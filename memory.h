@@ -32,6 +32,19 @@ public:
 						memory[offset] = val;
 					}
 				};
+
+	virtual const Byte*	read_ptr(Word offset, size_t len) {
+					return (offset + len <= size) ? &memory[offset] : nullptr;
+				}
+
+	virtual Byte*		write_ptr(Word offset, size_t len) {
+					return (offset + len <= size) ? &memory[offset] : nullptr;
+				}
+
+	virtual bool		read_is_passive(Word offset) {
+					(void)offset;
+					return true;
+				}
 };
 
 /*
@@ -58,10 +71,17 @@ public:
 					(void)val;
 				}
 
+	virtual Byte*		write_ptr(Word offset, size_t len) {
+					(void)offset;
+					(void)len;
+					return nullptr;
+				}
+
 public:
-		void		load(const char *filename, Word base);
-		void		load_intelhex(const char *filename, Word base);
-		void		load_decb(const char *filename, Word base);
+		void		load(const char *filename, Word base);	// exits on failure
+		bool		try_load(const char *filename, Word base);
+		bool		load_intelhex(const char *filename, Word base);
+		bool		load_decb(const char *filename, Word base);
 
 };
 
@@ -94,4 +114,17 @@ public:
 					(void)offset;
 					(void)val;
 				}
+
+	virtual const Byte*	read_ptr(Word offset, size_t len) {
+					if (offset + len <= size && offset + len <= memsize) {
+						return memory + offset;
+					} else {
+						return nullptr;
+					}
+				}
+
+	virtual bool		read_is_passive(Word offset) {
+					(void)offset;
+					return true;
+				}
 };
@@ -0,0 +1,442 @@
+//
+//	microbench.cpp
+//
+//	Times each opcode, and each indexed addressing form, on its own
+//	by running a long stream of just that instruction, printing the
+//	host time per instruction as a table
+//
+//	usim-microbench [-3] [-c cycles] [-r repeats] [-m mnemonic] [-s]
+//
+//	The cost over that of NOP is what the instruction's decode and
+//	execution add to the fixed cost of dispatching it.  Opcodes that
+//	would leave the stream (RTS, SWI, SYNC, ...) and TFM are left out,
+//	as are any opcodes and addressing forms the CPU doesn't implement.
+//
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+#include "mc6809.h"
+#include "hd6309.h"
+#include "memory.h"
+#include "disasm.h"
+
+//---------------------------------------------------------------------
+//
+// instruction streams
+//
+//---------------------------------------------------------------------
+
+// The indexed forms, with X pointing into RAM filled with $10
+// so that indirect addresses also land there
+struct index_form {
+	const char*		name;
+	Byte			post;
+	Byte			extra;		// offset bytes
+	bool			hd6309;		// only on the 6309
+};
+
+static const index_form index_forms[] = {
+	{ ",X",			0x84,	0,	false },
+	{ "5-bit,X",		0x01,	0,	false },
+	{ "8-bit,X",		0x88,	1,	false },
+	{ "16-bit,X",		0x89,	2,	false },
+	{ "A,X",		0x86,	0,	false },
+	{ "B,X",		0x85,	0,	false },
+	{ "D,X",		0x8b,	0,	false },
+	{ ",X+",		0x80,	0,	false },
+	{ ",X++",		0x81,	0,	false },
+	{ ",-X",		0x82,	0,	false },
+	{ ",--X",		0x83,	0,	false },
+	{ "8-bit,PCR",		0x8c,	1,	false },
+	{ "16-bit,PCR",		0x8d,	2,	false },
+	{ "[,X]",		0x94,	0,	false },
+	{ "[16-bit,X]",		0x99,	2,	false },
+	{ "[address]",		0x9f,	2,	false },
+	{ "E,X",		0x87,	0,	true },
+	{ "F,X",		0x8a,	0,	true },
+	{ "W,X",		0x8e,	0,	true },
+	{ ",W",			0x8f,	0,	true },
+	{ "16-bit,W",		0xaf,	2,	true },
+	{ ",W++",		0xcf,	0,	true },
+	{ ",--W",		0xef,	0,	true },
+};
+
+static const Word code_base = 0x8000;
+static const Word ram_ptr = 0x1000;		// X, and [address]
+static const int copies = 512;
+
+// Sets up the registers the streams rely on
+static const Byte prologue_6809[] = {
+	0x10, 0xce, 0x40, 0x00,		// 	LDS	#$4000
+	0xce, 0x30, 0x00,		// 	LDU	#$3000
+	0x8e, 0x10, 0x00,		// 	LDX	#$1000
+	0x10, 0x8e, 0x18, 0x00,		// 	LDY	#$1800
+	0x4f,				// 	CLRA
+	0x1f, 0x8b,			// 	TFR	A,DP
+	0xcc, 0x00, 0x10,		// 	LDD	#$0010
+};
+
+static const Byte prologue_6309[] = {
+	0x10, 0x86, 0x20, 0x00,		// 	LDW	#$2000
+};
+
+struct Stream {
+	std::string		mnemonic;
+	std::string		operand;
+	Word			ir;
+	std::vector<Byte>	code;
+};
+
+// Appends one copy of the instruction to `code`, at `addr`, with
+// any branch or jump going to the instruction following it.
+// Returns false for opcodes that would leave the stream.
+static bool emit(std::vector<Byte>& code, Word ir, const Disassembler::opcode& op, const index_form* form, std::string& operand)
+{
+	using D = Disassembler;
+
+	static const char* const leaves[] = {
+		"RTS", "RTI", "SWI", "SWI2", "SWI3", "SYNC", "CWAI", nullptr
+	};
+	for (const char* const* l = leaves; *l; ++l) {
+		if (strcmp(op.mnemonic, *l) == 0) {
+			return false;
+		}
+	}
+	bool jump = strcmp(op.mnemonic, "JMP") == 0 || strcmp(op.mnemonic, "JSR") == 0;
+	if (jump && op.mode != D::extended) {
+		return false;
+	}
+
+	Word start = code_base + code.size();
+	if (ir > 0xff) {
+		code.push_back(ir >> 8);
+	}
+	code.push_back(ir & 0xff);
+
+	auto word = [&](Word w) {
+		code.push_back(w >> 8);
+		code.push_back(w & 0xff);
+	};
+
+	switch (op.mode) {
+		case D::inherent:
+			operand = "";
+			break;
+		case D::imm8:
+			code.push_back(0x01);
+			operand = "#imm8";
+			break;
+		case D::imm16:
+			word(0x0101);
+			operand = "#imm16";
+			break;
+		case D::imm32:
+			word(0x0001);
+			word(0x0001);
+			operand = "#imm32";
+			break;
+		case D::direct:
+			code.push_back(0x40);
+			operand = "<direct";
+			break;
+		case D::extended:
+			if (jump) {
+				word(start + (ir > 0xff ? 4 : 3));
+			} else {
+				word(0x0400);
+			}
+			operand = ">extended";
+			break;
+		case D::rel8:
+			code.push_back(0x00);
+			operand = "rel8";
+			break;
+		case D::rel16:
+			word(0x0000);
+			operand = "rel16";
+			break;
+		case D::regpair:
+			code.push_back(0x12);		// X,Y
+			operand = "X,Y";
+			break;
+		case D::reglist_s:
+		case D::reglist_u:
+			code.push_back(0x7f);		// everything but PC
+			operand = "7 registers";
+			break;
+		case D::bitop:
+			code.push_back(0x40);		// A bit 0, bit 0
+			code.push_back(0x40);
+			operand = "A.0,<direct.0";
+			break;
+		case D::imm_direct:
+			code.push_back(0x01);
+			code.push_back(0x40);
+			operand = "#imm8,<direct";
+			break;
+		case D::imm_extended:
+			code.push_back(0x01);
+			word(0x0400);
+			operand = "#imm8,>extended";
+			break;
+		case D::imm_indexed:
+			code.push_back(0x01);
+			// fall through
+		case D::indexed:
+			code.push_back(form->post);
+			if (form->extra == 1) {
+				code.push_back(0x01);
+			} else if (form->extra == 2) {
+				word(form->post == 0x9f ? ram_ptr : 0x0001);
+			}
+			operand = op.mode == D::imm_indexed ? std::string("#imm8,") + form->name : form->name;
+			break;
+		default:
+			return false;
+	}
+
+	return true;
+}
+
+// All the streams for one instruction set, the first being NOP
+static std::vector<Stream> streams(Disassembler::instruction_set set)
+{
+	Disassembler disasm(set);
+	std::vector<Stream> all;
+	bool hd6309 = set == Disassembler::hd6309_set;
+
+	std::vector<Word> irs = { 0x12 };
+	for (Word page : { 0x0000, 0x1000, 0x1100 }) {
+		for (Word i = 0; i < 256; ++i) {
+			if (page + i != 0x12) {
+				irs.push_back(page + i);
+			}
+		}
+	}
+
+	for (Word ir : irs) {
+		const Disassembler::opcode& op = disasm.lookup(ir);
+		bool is_indexed = op.mode == Disassembler::indexed || op.mode == Disassembler::imm_indexed;
+
+		for (const index_form& form : index_forms) {
+			if (form.hd6309 && !hd6309) {
+				continue;
+			}
+
+			Stream s;
+			s.mnemonic = op.mnemonic;
+			s.ir = ir;
+			s.code.assign(prologue_6809, prologue_6809 + sizeof prologue_6809);
+			if (hd6309) {
+				s.code.insert(s.code.end(), prologue_6309, prologue_6309 + sizeof prologue_6309);
+			}
+
+			bool ok = true;
+			for (int i = 0; i < copies && ok; ++i) {
+				ok = emit(s.code, ir, op, &form, s.operand);
+			}
+			if (ok) {
+				s.code.push_back(0x7e);		// JMP	code_base
+				s.code.push_back(code_base >> 8);
+				s.code.push_back(code_base & 0xff);
+				all.push_back(s);
+			}
+
+			if (!is_indexed) {
+				break;
+			}
+		}
+	}
+
+	return all;
+}
+
+//---------------------------------------------------------------------
+//
+// running and timing
+//
+//---------------------------------------------------------------------
+
+// A CPU that says whether it implements an opcode, and that just
+// stops on an invalid instruction or addressing form
+template<class CPU>
+class Probe : public CPU {
+
+protected:
+	bool			failed = false;
+
+public:
+	virtual void		invalid(const char*) { failed = true; this->halt(); };
+
+	bool			has_failed() const { return failed; };
+	bool			stuck() const { return this->pc < code_base || this->pc >= 0xff00; };
+
+	// not the NOP that fills the gaps in the dispatch table
+	bool			implements(Word ir) const {
+					Word page = (ir >> 8) ? (ir >> 8) - 0x0f : 0;
+					const char* m = this->opcodes[page * 256 + (ir & 0xff)].mnemonic;
+					return ir == 0x12 || strcmp(m, "NOP") != 0;
+				};
+
+};
+
+struct Timing {
+	double			ns;		// host time per instruction
+	double			cycles;		// emulated cycles per instruction
+};
+
+// Returns false if the CPU doesn't implement the stream's instruction
+template<class CPU>
+static bool run(const Stream& s, Cycles budget, int repeats, Timing& best)
+{
+	for (int i = 0; i < repeats; ++i) {
+		Probe<CPU>		cpu;
+		std::vector<Byte>	image(0x8000, 0xff);
+
+		if (!cpu.implements(s.ir)) {
+			return false;
+		}
+
+		auto ram = std::make_shared<RAM>(0x8000);
+		memset(ram->write_ptr(0, 0x8000), 0x10, 0x8000);
+
+		// any trap ends up in a loop of its own at $FF00
+		memcpy(image.data(), s.code.data(), s.code.size());
+		image[0x7f00] = 0x20;			// BRA	*
+		image[0x7f01] = 0xfe;
+		for (int v = 0x7ff0; v < 0x7ffe; v += 2) {
+			image[v] = 0xff;
+			image[v + 1] = 0x00;
+		}
+		image[0x7ffe] = code_base >> 8;
+		image[0x7fff] = code_base & 0xff;
+
+		cpu.attach(ram, 0x0000, 0x8000);
+		cpu.attach(std::make_shared<ROM_Data>(image.data(), image.size()), code_base, 0x8000);
+
+		cpu.reset();
+
+		auto start = std::chrono::steady_clock::now();
+		cpu.run_for(budget);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (cpu.has_failed() || cpu.stuck()) {
+			return false;
+		}
+
+		Timing t = {
+			elapsed.count() * 1e9 / cpu.instruction_count(),
+			(double)cpu.cycle_count() / cpu.instruction_count()
+		};
+		if (i == 0 || t.ns < best.ns) {
+			best = t;
+		}
+	}
+
+	return true;
+}
+
+struct Row {
+	const Stream*		stream;
+	Timing			timing;
+};
+
+template<class CPU>
+static void table(const char* cpu_name, Disassembler::instruction_set set, Cycles budget, int repeats, const char* only, bool sorted)
+{
+	std::vector<Stream> all = streams(set);
+	std::vector<Row> rows;
+	size_t skipped = 0;
+	double nop = 0;
+
+	for (const Stream& s : all) {
+		if (only && s.ir != 0x12 && strcasecmp(s.mnemonic.c_str(), only) != 0) {
+			continue;
+		}
+
+		Timing t;
+		if (!run<CPU>(s, budget, repeats, t)) {
+			++skipped;
+			continue;
+		}
+		if (s.ir == 0x12) {
+			nop = t.ns;
+		}
+		rows.push_back({ &s, t });
+	}
+
+	if (sorted) {
+		std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+			return a.timing.ns > b.timing.ns;
+		});
+	}
+
+	printf("%-6s  %-6s  %-8s  %-20s %8s %8s %7s\n",
+		"cpu", "opcode", "mnemonic", "operand", "ns", "+nop", "cycles");
+	for (const Row& r : rows) {
+		printf("%-6s  %-6X  %-8s  %-20s %8.2f %+8.2f %7.2f\n",
+			cpu_name, r.stream->ir, r.stream->mnemonic.c_str(), r.stream->operand.c_str(),
+			r.timing.ns, r.timing.ns - nop, r.timing.cycles);
+	}
+	if (skipped) {
+		printf("# %zu opcode and addressing form combinations not implemented by %s\n",
+			skipped, cpu_name);
+	}
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: usim-microbench [-3] [-c cycles] [-r repeats] [-m mnemonic] [-s]\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	Disassembler::instruction_set set = Disassembler::mc6809_set;
+	Cycles budget = 200000;
+	int repeats = 3;
+	const char* only = nullptr;
+	bool sorted = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "3c:r:m:s")) != -1) {
+		switch (opt) {
+			case '3':
+				set = Disassembler::hd6309_set;
+				break;
+			case 'c':
+				budget = strtoull(optarg, NULL, 0);
+				break;
+			case 'r':
+				repeats = atoi(optarg);
+				break;
+			case 'm':
+				only = optarg;
+				break;
+			case 's':
+				sorted = true;
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc || budget == 0 || repeats < 1) {
+		usage();
+	}
+
+	if (set == Disassembler::hd6309_set) {
+		table<hd6309>("hd6309", Disassembler::hd6309_set, budget, repeats, only, sorted);
+	} else {
+		table<mc6809>("mc6809", Disassembler::mc6809_set, budget, repeats, only, sorted);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+//
+//	pacer.cpp
+//
+
+#include <thread>
+#include <cinttypes>
+#include "pacer.h"
+
+using namespace std::chrono;
+
+Pacer::Pacer(double hz, unsigned slice_ms, unsigned resync_ms)
+	: hz(hz),
+	  slice(hz * slice_ms / 1000),
+	  resync(milliseconds(resync_ms))
+{
+	if (slice == 0) {
+		slice = 1;
+	}
+}
+
+void Pacer::reset()
+{
+	base = started = checked = host_clock::now();
+	base_cycles = started_cycles = checked_cycles = now();
+	wake_at(now() + slice);
+}
+
+void Pacer::tick(Cycles now)
+{
+	wake_at(now + slice);
+
+	auto due = base + duration_cast<host_clock::duration>(duration<double>((now - base_cycles) / hz));
+	auto host = host_clock::now();
+
+	++checks;
+	checked_cycles = now;
+	if (due > host) {
+		++sleeps;
+		std::this_thread::sleep_until(due);
+		checked = host_clock::now();
+		return;
+	}
+	checked = host;
+
+	auto late = host - due;
+	late_total += late;
+	if (late > late_max) {
+		late_max = late;
+	}
+
+	// stopped in the debugger, or a host too slow for this rate
+	if (late > resync) {
+		++resyncs;
+		lost += late;
+		base = host;
+		base_cycles = now;
+	}
+}
+
+void Pacer::report(FILE* fp) const
+{
+	Cycles cycles = checked_cycles - started_cycles;
+	double host = duration<double>(checked - started).count();
+	auto ms = [](host_clock::duration d) {
+		return duration<double, std::milli>(d).count();
+	};
+
+	fprintf(fp, "paced %" PRIu64 " cycles in %.3fs: %.4f MHz for %.4f MHz, %+.2f%%\n",
+		cycles, host, host ? cycles / host / 1e6 : 0.0, hz / 1e6,
+		host ? 100.0 * (cycles / host - hz) / hz : 0.0);
+	fprintf(fp, "%" PRIu64 " checks, %" PRIu64 " slept, late by %.3fms on average and %.3fms at most",
+		checks, sleeps, checks ? ms(late_total) / checks : 0.0, ms(late_max));
+	if (resyncs) {
+		fprintf(fp, ", %" PRIu64 " resyncs lost %.3fms", resyncs, ms(lost));
+	}
+	fprintf(fp, "\n");
+}
@@ -0,0 +1,55 @@
+//
+//	pacer.h
+//
+
+#pragma once
+
+#include <cstdio>
+#include <chrono>
+#include "device.h"
+
+/*
+ * holds the guest to real time at a given clock rate
+ *
+ * every slice of guest time it sleeps until the host has caught
+ * up, so the host core is idle rather than spinning; if the host
+ * falls too far behind to catch up it starts again from where it
+ * is, and counts the time lost rather than running flat out
+ */
+class Pacer : virtual public ActiveDevice {
+
+protected:
+	using host_clock = std::chrono::steady_clock;
+
+	double			hz;
+	Cycles			slice;		// guest cycles between sleeps
+	host_clock::duration	resync;		// how far behind is too far
+
+	// guest time `base_cycles` was due at host time `base`
+	host_clock::time_point	base;
+	Cycles			base_cycles = 0;
+
+	// drift, for report(), measured up to the last check since
+	// the guest runs unchecked for up to a slice after that
+	host_clock::time_point	started, checked;
+	Cycles			started_cycles = 0;
+	Cycles			checked_cycles = 0;
+	host_clock::duration	late_max{0};	// furthest behind when checked
+	host_clock::duration	late_total{0};	// summed over every check
+	host_clock::duration	lost{0};	// dropped by resyncing
+	uint64_t		checks = 0;
+	uint64_t		sleeps = 0;
+	uint64_t		resyncs = 0;
+
+public:
+	virtual void		reset();
+	virtual void		tick(Cycles now);
+
+	// the rate actually achieved and how far it strayed
+	void			report(FILE* fp) const;
+
+// Public constructor
+public:
+				Pacer(double hz, unsigned slice_ms = 10, unsigned resync_ms = 250);
+
+};
@@ -0,0 +1,378 @@
+//
+//	profile.cpp
+//
+
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+#include <cinttypes>
+#include <algorithm>
+#include <map>
+
+#include "profile.h"
+
+//---------------------------------------------------------------------
+//
+// symbols from asm6809 listings
+//
+//---------------------------------------------------------------------
+
+// A listing line is the address, the bytes generated, and then the
+// source line verbatim, starting in a fixed column:
+//
+// C000 10CE0200         reset   lds     #system_stack
+// C004                  loop
+//
+// Returns where this line's source text starts if that can be told
+// from it alone, or std::string::npos
+static size_t text_start(const std::string& line, bool& has_addr)
+{
+	size_t i = 0;
+
+	has_addr = line.size() >= 5 && isspace((unsigned char)line[4]) &&
+		std::all_of(line.begin(), line.begin() + 4, [](char c) { return isxdigit((unsigned char)c); });
+
+	if (has_addr) {
+		i = 4;
+		while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+
+		// skip the generated bytes, if any
+		size_t j = i;
+		while (j < line.size() && isxdigit((unsigned char)line[j])) ++j;
+		if (j > i && j < line.size() && isspace((unsigned char)line[j])) {
+			i = j;
+			while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+		}
+	} else {
+		while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+	}
+
+	return i < line.size() ? i : std::string::npos;
+}
+
+static std::string token(const std::string& line, size_t& i)
+{
+	while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+	size_t start = i;
+	while (i < line.size() && !isspace((unsigned char)line[i])) ++i;
+	return line.substr(start, i - start);
+}
+
+bool Symbols::load_listing(const char* filename)
+{
+	FILE* fp = fopen(filename, "r");
+	if (!fp) {
+		return false;
+	}
+
+	std::vector<std::string> lines;
+	char buf[256];
+	std::string line;
+	while (fgets(buf, sizeof buf, fp)) {
+		line += buf;
+		if (line.back() == '\n') {
+			line.pop_back();
+			lines.push_back(line);
+			line.clear();
+		}
+	}
+	if (!line.empty()) {
+		lines.push_back(line);
+	}
+	fclose(fp);
+
+	// the source column is as far left as any line's text starts,
+	// since only a label or comment starts in that column itself
+	size_t column = std::string::npos;
+	for (auto& l : lines) {
+		bool has_addr;
+		column = std::min(column, text_start(l, has_addr));
+	}
+	if (column == std::string::npos || column < 5) {
+		return false;
+	}
+
+	int last = -1;
+	for (auto& l : lines) {
+		bool has_addr;
+		text_start(l, has_addr);
+		if (!has_addr) {
+			continue;
+		}
+
+		Word addr = strtoul(l.substr(0, 4).c_str(), NULL, 16);
+		bool labelled = l.size() > column && !isspace((unsigned char)l[column]) &&
+			isspace((unsigned char)l[column - 1]);
+
+		if (labelled) {
+			size_t i = column;
+			std::string label = token(l, i);
+			std::string directive = token(l, i);
+
+			if (!label.empty() && label.back() == ':') {
+				label.pop_back();
+			}
+
+			// constants aren't code addresses
+			if (strcasecmp(directive.c_str(), "equ") == 0 ||
+			    strcasecmp(directive.c_str(), "set") == 0)
+			{
+				continue;
+			}
+
+			if (!label.empty() && label[0] != ';' && label[0] != '*' &&
+			    !isdigit((unsigned char)label[0]))
+			{
+				table.emplace_back(addr, label);
+			}
+		}
+		last = std::max(last, (int)addr);
+	}
+
+	if (last >= 0 && last < 0xffff) {
+		table.emplace_back(last + 1, "");
+	}
+
+	// where an address has both, the label takes precedence
+	std::sort(table.begin(), table.end());
+
+	return true;
+}
+
+const std::pair<Word, std::string>* Symbols::find(Word addr) const
+{
+	auto it = std::upper_bound(table.begin(), table.end(), addr,
+		[](Word a, const std::pair<Word, std::string>& e) { return a < e.first; });
+
+	if (it == table.begin() || (--it)->second.empty()) {
+		return nullptr;
+	}
+	return &*it;
+}
+
+std::string Symbols::label(Word addr) const
+{
+	auto e = find(addr);
+	return e ? e->second : "";
+}
+
+std::string Symbols::lookup(Word addr) const
+{
+	auto e = find(addr);
+	if (!e) {
+		return "";
+	}
+	if (e->first == addr) {
+		return e->second;
+	}
+
+	char offset[8];
+	snprintf(offset, sizeof offset, "+$%X", addr - e->first);
+	return e->second + offset;
+}
+
+//---------------------------------------------------------------------
+//
+// hot-spot report
+//
+//---------------------------------------------------------------------
+
+void Profile::report(FILE* fp, const Symbols& symbols, Cycles elapsed, size_t top) const
+{
+	uint64_t total_count = 0;
+	uint64_t total_cycles = 0;
+	std::vector<Word> hot;
+
+	for (DWord pc = 0; pc < 0x10000; ++pc) {
+		if (counters[pc].count) {
+			total_count += counters[pc].count;
+			total_cycles += counters[pc].cycles;
+			hot.push_back(pc);
+		}
+	}
+
+	auto pct = [&](uint64_t cycles) {
+		return total_cycles ? 100.0 * cycles / total_cycles : 0.0;
+	};
+
+	fprintf(fp, "%" PRIu64 " instructions took %" PRIu64 " cycles",
+		total_count, total_cycles);
+	if (elapsed > total_cycles) {
+		fprintf(fp, ", and %" PRIu64 " more were spent waiting or idle",
+			elapsed - total_cycles);
+	}
+	fprintf(fp, "\n");
+
+	// totals for each label, for everything up to the next
+	if (!symbols.empty()) {
+		std::map<std::string, counter> by_label;
+		for (Word pc : hot) {
+			counter& c = by_label[symbols.label(pc)];
+			c.count += counters[pc].count;
+			c.cycles += counters[pc].cycles;
+		}
+
+		std::vector<std::pair<std::string, counter>> sorted(by_label.begin(), by_label.end());
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+			return a.second.cycles > b.second.cycles;
+		});
+
+		fprintf(fp, "\n%12s %7s %7s %12s  %s\n", "cycles", "%", "cum%", "count", "symbol");
+		uint64_t cum = 0;
+		for (size_t i = 0; i < sorted.size() && i < top; ++i) {
+			const counter& c = sorted[i].second;
+			cum += c.cycles;
+			fprintf(fp, "%12" PRIu64 " %6.2f%% %6.2f%% %12" PRIu64 "  %s\n",
+				c.cycles, pct(c.cycles), pct(cum), c.count,
+				sorted[i].first.empty() ? "?" : sorted[i].first.c_str());
+		}
+	}
+
+	std::sort(hot.begin(), hot.end(), [this](Word a, Word b) {
+		return counters[a].cycles > counters[b].cycles;
+	});
+
+	fprintf(fp, "\n%12s %7s %12s %5s  %-4s  %s\n", "cycles", "%", "count", "avg", "pc", "symbol");
+	for (size_t i = 0; i < hot.size() && i < top; ++i) {
+		const counter& c = counters[hot[i]];
+		fprintf(fp, "%12" PRIu64 " %6.2f%% %12" PRIu64 " %5.1f  %04X  %s\n",
+			c.cycles, pct(c.cycles), c.count, (double)c.cycles / c.count,
+			hot[i], symbols.lookup(hot[i]).c_str());
+	}
+}
+
+//---------------------------------------------------------------------
+//
+// call graph
+//
+//---------------------------------------------------------------------
+
+void CallGraph::call(Word routine, Word sp, Cycles now)
+{
+	charge(now);
+
+	// the stack only grows downwards through a call, so any frames
+	// at or below this one have already been abandoned
+	while (!stack.empty() && stack.back().sp <= sp) {
+		stack.pop_back();
+	}
+	uint32_t parent = stack.empty() ? 0 : stack.back().node;
+
+	auto ins = children.emplace((uint64_t)parent << 16 | routine, nodes.size());
+	if (ins.second) {
+		nodes.push_back({ routine, parent, 0, 0 });
+	}
+	current = ins.first->second;
+	++nodes[current].calls;
+	stack.push_back({ current, sp });
+}
+
+void CallGraph::ret(Word sp, Cycles now)
+{
+	charge(now);
+
+	// the return has popped every frame that's now above the stack
+	while (!stack.empty() && stack.back().sp < sp) {
+		stack.pop_back();
+	}
+	current = stack.empty() ? 0 : stack.back().node;
+}
+
+std::string CallGraph::name(const Symbols& symbols, const node& n) const
+{
+	if (&n == &nodes[0]) {
+		return "[start]";
+	}
+
+	std::string s = symbols.lookup(n.routine);
+	if (s.empty()) {
+		char addr[8];
+		snprintf(addr, sizeof addr, "$%04X", n.routine);
+		s = addr;
+	}
+	return s;
+}
+
+void CallGraph::collapsed(FILE* fp, const Symbols& symbols) const
+{
+	for (const node& n : nodes) {
+		if (!n.cycles) {
+			continue;
+		}
+
+		std::vector<const node*> chain;
+		for (const node* p = &n; p != &nodes[0]; p = &nodes[p->parent]) {
+			chain.push_back(p);
+		}
+		chain.push_back(&nodes[0]);
+
+		std::string line;
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+			if (!line.empty()) {
+				line += ';';
+			}
+			line += name(symbols, **it);
+		}
+		fprintf(fp, "%s %" PRIu64 "\n", line.c_str(), n.cycles);
+	}
+}
+
+void CallGraph::report(FILE* fp, const Symbols& symbols, size_t top) const
+{
+	struct totals {
+		const node*	first;		// for its name
+		uint64_t	inclusive;
+		uint64_t	exclusive;
+		uint64_t	calls;
+	};
+
+	// a node is created after its parent, so running backwards
+	// sees every child before the parent it adds into
+	std::vector<uint64_t> inclusive(nodes.size());
+	for (size_t i = nodes.size(); i-- > 0; ) {
+		inclusive[i] += nodes[i].cycles;
+		if (i) {
+			inclusive[nodes[i].parent] += inclusive[i];
+		}
+	}
+
+	std::map<DWord, totals> by_routine;		// the root is keyed 0x10000
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const node& n = nodes[i];
+		DWord key = i ? n.routine : 0x10000;
+		totals& t = by_routine.emplace(key, totals{ &n, 0, 0, 0 }).first->second;
+
+		t.exclusive += n.cycles;
+		t.calls += n.calls;
+
+		// recursive calls are already counted by the outermost
+		bool nested = false;
+		for (uint32_t p = n.parent; i && p && !nested; p = nodes[p].parent) {
+			nested = nodes[p].routine == n.routine;
+		}
+		if (!nested) {
+			t.inclusive += inclusive[i];
+		}
+	}
+
+	std::vector<totals> sorted;
+	for (auto& r : by_routine) {
+		sorted.push_back(r.second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const totals& a, const totals& b) {
+		return a.inclusive > b.inclusive;
+	});
+
+	uint64_t total = inclusive[0];
+	auto pct = [&](uint64_t cycles) {
+		return total ? 100.0 * cycles / total : 0.0;
+	};
+
+	fprintf(fp, "\n%12s %7s %12s %7s %12s  %s\n", "inclusive", "%", "exclusive", "%", "calls", "routine");
+	for (size_t i = 0; i < sorted.size() && i < top; ++i) {
+		const totals& t = sorted[i];
+		fprintf(fp, "%12" PRIu64 " %6.2f%% %12" PRIu64 " %6.2f%% %12" PRIu64 "  %s\n",
+			t.inclusive, pct(t.inclusive), t.exclusive, pct(t.exclusive), t.calls,
+			name(symbols, *t.first).c_str());
+	}
+}
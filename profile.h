@@ -0,0 +1,127 @@
+//
+//	profile.h
+//
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "typedefs.h"
+
+/*
+ * guest code addresses and the labels on them, as read from
+ * the listings written by asm6809 --listing
+ */
+class Symbols {
+
+protected:
+	// sorted by address, with an unnamed entry just past the
+	// code in each listing, so nothing beyond it is claimed
+	std::vector<std::pair<Word, std::string>>	table;
+
+	const std::pair<Word, std::string>*	find(Word addr) const;
+
+public:
+	bool			load_listing(const char* filename);
+	bool			empty() const { return table.empty(); };
+
+	// "label" or "label+$xx", or "" if not within a listing
+	std::string		lookup(Word addr) const;
+
+	// just the label at or before `addr`, as above
+	std::string		label(Word addr) const;
+
+};
+
+/*
+ * cycles and execution counts accumulated against the address
+ * of every instruction the CPU runs
+ */
+class Profile {
+
+protected:
+	struct counter {
+		uint64_t	count;
+		uint64_t	cycles;
+	};
+
+	std::vector<counter>	counters;
+
+public:
+	void			add(Word pc, Byte cycles) {
+					counter& c = counters[pc];
+					++c.count;
+					c.cycles += cycles;
+				};
+
+	// writes the `top` hottest symbols and addresses, and how
+	// much of the `elapsed` cycles went unaccounted for (spent
+	// waiting for interrupts or in skipped idle loops)
+	void			report(FILE* fp, const Symbols& symbols, Cycles elapsed, size_t top = 50) const;
+
+// Public constructor
+public:
+				Profile() : counters(0x10000) {};
+
+};
+
+/*
+ * cycles attributed to guest routines through a shadow of the
+ * call stack, kept from the calls, returns and interrupts the
+ * CPU reports
+ *
+ * each distinct chain of calls is a node, charged with the cycles
+ * spent in its last routine; frames are matched to returns by the
+ * stack pointer, so those left by PULS PC or a reset stack pointer
+ * are dropped once the stack has moved above them
+ */
+class CallGraph {
+
+protected:
+	struct node {
+		Word		routine;
+		uint32_t	parent;
+		uint64_t	calls;
+		uint64_t	cycles;		// exclusive
+	};
+
+	struct frame {
+		uint32_t	node;
+		Word		sp;		// holding the return address
+	};
+
+	std::vector<node>	nodes;		// [0] is whatever ran first
+	std::unordered_map<uint64_t, uint32_t>
+				children;	// parent << 16 | routine -> node
+	std::vector<frame>	stack;
+	uint32_t		current = 0;
+	Cycles			last = 0;
+
+	void			charge(Cycles now) {
+					nodes[current].cycles += now - last;
+					last = now;
+				};
+
+	std::string		name(const Symbols& symbols, const node& n) const;
+
+public:
+	// `now` is when the call, return or interrupt completes
+	void			call(Word routine, Word sp, Cycles now);
+	void			ret(Word sp, Cycles now);
+	void			stop(Cycles now) { charge(now); };
+
+	// one line per chain of calls, "a;b;c cycles", as taken by
+	// flamegraph.pl and similar tools
+	void			collapsed(FILE* fp, const Symbols& symbols) const;
+
+	// the `top` routines by inclusive cycles, counting recursive
+	// calls once, with their exclusive cycles and calls
+	void			report(FILE* fp, const Symbols& symbols, size_t top = 50) const;
+
+// Public constructor
+public:
+				CallGraph() : nodes(1, node{0, 0, 0, 0}) {};
+
+};
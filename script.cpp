@@ -0,0 +1,54 @@
+//
+//	script.cpp
+//
+
+#include <cstdio>
+#include "script.h"
+
+// Reads the whole input script, with newlines sent as carriage
+// returns the same as a file inserted at the terminal
+bool Script::load(const char *filename)
+{
+	FILE *fp = fopen(filename, "r");
+	if (!fp) {
+		return false;
+	}
+
+	int c;
+	while ((c = fgetc(fp)) != EOF) {
+		input.push_back(c == '\n' ? '\r' : c);
+	}
+	fclose(fp);
+
+	return true;
+}
+
+// Adds to the input as if typed, with the same newline handling
+void Script::type(const std::string& text)
+{
+	for (char c : text) {
+		input.push_back(c == '\n' ? '\r' : c);
+	}
+}
+
+bool Script::poll_read()
+{
+	return input_pos < input.size();
+}
+
+// The script is typed in as fast as the guest reads it
+bool Script::next_read_delay(Cycles& delay)
+{
+	delay = 0;
+	return input_pos < input.size();
+}
+
+Byte Script::read()
+{
+	return input[input_pos++];
+}
+
+void Script::write(Byte ch)
+{
+	output.push_back(ch);
+}
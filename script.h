@@ -0,0 +1,37 @@
+//
+//	script.h
+//
+
+#pragma once
+
+#include <string>
+#include "mc6850.h"
+
+/*
+ * a terminal with no user: input comes from a host file, as if
+ * typed, and all output is collected in memory
+ */
+class Script : virtual public mc6850_impl {
+
+protected:
+	std::string			input;
+	size_t				input_pos = 0;
+	std::string			output;
+
+public:
+	virtual bool		poll_read();
+	virtual void		write(Byte);
+	virtual Byte		read();
+	virtual bool		next_read_delay(Cycles& delay);
+
+public:
+	bool				load(const char *filename);
+	void				type(const std::string& text);
+	const std::string&	get_output() const { return output; };
+
+// Public constructor and destructor
+public:
+						Script() = default;
+	virtual				~Script() = default;
+
+};
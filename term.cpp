@@ -30,9 +30,10 @@ Terminal::Terminal(USim& sys) : sys(sys)
 	input_fd = fileno(input);
 	insert_fd = -1;
 
-	// Set input and output to be unbuffered
+	// Set input to be unbuffered, and output fully buffered
+	// as it's flushed by flush_output() when it needs to be
 	setbuf(input, (char *)0);
-	setbuf(output, (char *)0);
+	setvbuf(output, (char *)0, _IOFBF, BUFSIZ);
 
 	// Get copies of startup terminal attributes
 	tcgetattr(input_fd, &oattr);
@@ -43,6 +44,7 @@ Terminal::Terminal(USim& sys) : sys(sys)
 
 Terminal::~Terminal()
 {
+	flush_output();
 	reset();
 }
 
@@ -71,44 +73,59 @@ bool Terminal::real_poll_read()
 
 	// Uses minimal (10us) delay in select(2) call to
 	// ensure that idling simulations don't chew
-	// up masses of CPU time
-	static struct timeval	tv = { 0L, 10L };
+	// up masses of CPU time (and as select(2) may
+	// update it, must be set afresh every call)
+	struct timeval	tv = { 0L, 10L };
 
-	FD_ZERO(&fds);
-	FD_SET(input_fd, &fds);
-
-	// Are we inserting a host file into the terminal stream?
+	// An inserted file is always readable, so until it runs
+	// out there's no need to ask, nor to look at the console
 	if (insert_fd != -1) {
-		FD_SET(insert_fd, &fds);
+		int c = fgetc(insert);
+		if (c != EOF) {
+			ungetc(c, insert);
+			insert_data_available = true;
+			return true;
+		}
+
+		fclose(insert);
+		insert = NULL;
+		insert_fd = -1;
+		insert_data_available = false;
 	}
 
+	FD_ZERO(&fds);
+	FD_SET(input_fd, &fds);
+
 	(void)select(FD_SETSIZE, &fds, NULL, NULL, &tv);
 
-	if (insert_fd != -1) {
-		insert_data_available = FD_ISSET(insert_fd, &fds);
+	return FD_ISSET(input_fd, &fds);
+}
+
+// Sleep until there's console input, unless a file is being inserted
+void Terminal::wait_read()
+{
+	fd_set			fds;
+
+	if (read_data_available || insert_fd != -1) {
+		return;
 	}
 
-	return FD_ISSET(input_fd, &fds) || insert_data_available;
+	flush_output();
+
+	FD_ZERO(&fds);
+	FD_SET(input_fd, &fds);
+
+	(void)select(FD_SETSIZE, &fds, NULL, NULL, NULL);
 }
 
 Byte Terminal::real_read()
 {
+	// real_poll_read() has already seen that there's more
 	if (insert_data_available) {
 		char c = fgetc(insert);
 
-		if (c != EOF) {
-		  if (c == '\n')
-		    c = '\r';
-		  
-		  return c;
-		}
-
-		//printf("\r\nEnd of insert file.\r\n");
-
-		fclose(insert);
-		insert = NULL;
-		insert_fd = -1;
 		insert_data_available = false;
+		return c == '\n' ? '\r' : c;
 	}
 
 	return fgetc(input);
@@ -117,6 +134,13 @@ Byte Terminal::real_read()
 void Terminal::write(Byte ch)
 {
 	fputc(ch, output);
+	output_written(ch);
+}
+
+void Terminal::flush_output()
+{
+	fflush(output);
+	unflushed = false;
 }
 
 //------------------------------------------------------------------------
@@ -137,6 +161,10 @@ bool Terminal::real_poll_read()
 	return kbhit();
 }
 
+void Terminal::wait_read()
+{
+}
+
 Byte Terminal::real_read()
 {
 	return getch();
@@ -147,6 +175,11 @@ void Terminal::write(Byte ch)
 	putch(ch);
 }
 
+void Terminal::flush_output()
+{
+	unflushed = false;
+}
+
 void Terminal::setup()
 {
 }
@@ -207,6 +240,7 @@ bool Terminal::poll_read()
 		case 2:
 			tilde_escape_phase = 0;
 			read_data_available = false;
+			flush_output();
 
 			switch (ch) {
 				case '~':
@@ -235,6 +269,44 @@ bool Terminal::poll_read()
 	return read_data_available;
 }
 
+// Only a newline is worth looking at the time for, so bulk output
+// is flushed a line at a time, but never too often
+void Terminal::output_written(Byte ch)
+{
+	if (!unflushed) {
+		unflushed = true;
+		unflushed_since = host_clock::now();
+	} else if (ch == '\n' && host_clock::now() - unflushed_since >= flush_delay) {
+		flush_output();
+	}
+	written = true;
+}
+
+bool Terminal::injecting() const
+{
+	return insert_fd != -1;
+}
+
+// The line delay follows the carriage return a newline became
+bool Terminal::next_read_delay(Cycles& delay)
+{
+	if (!injecting()) {
+		return false;
+	}
+
+	delay = read_data == '\r' ? line_delay : 0;
+	return true;
+}
+
+// Output that's paused, as when echoing what's typed, goes at once
+void Terminal::tick()
+{
+	if (unflushed && (!written || host_clock::now() - unflushed_since >= flush_delay)) {
+		flush_output();
+	}
+	written = false;
+}
+
 bool Terminal::open_insert_file()
 {
 	char filename[255];
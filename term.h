@@ -8,6 +8,7 @@
 #pragma once
 
 #include <cstdio>
+#include <chrono>
 #include "usim.h"
 #include "mc6850.h"
 
@@ -24,12 +25,31 @@ protected:
 	bool				insert_data_available = false;
 	int					tilde_escape_phase = 0;
 
+	// output is written in batches, flushed as soon as the guest
+	// stops writing for a poll, or waits for input, and otherwise
+	// at most every flush_delay, at a newline or from tick()
+	using host_clock = std::chrono::steady_clock;
+
+	host_clock::duration	flush_delay = std::chrono::milliseconds(20);
+	host_clock::time_point	unflushed_since;
+	bool				unflushed = false;
+	bool				written = false;	// since the last tick()
+
+	void				output_written(Byte ch);
+	virtual void		flush_output();
+
+	// inserted files are read as fast as the guest takes them,
+	// pausing after each line for interpreters that need it
+	Cycles				line_delay = 0;
+
+	virtual bool		injecting() const;
+
 	void				tilde_escape_help();
 	virtual void		tilde_escape_help_other();
 	virtual void 		tilde_escape_do_other(char ch);
-	bool				real_poll_read();
-	Byte				real_read();
-	bool				open_insert_file();
+	virtual bool		real_poll_read();
+	virtual Byte		real_read();
+	virtual bool		open_insert_file();
 
 #ifdef _POSIX_SOURCE
 	FILE*				input;
@@ -42,8 +62,13 @@ protected:
 
 public:
 	virtual bool		poll_read();
+	virtual void		wait_read();
 	virtual void		write(Byte);
 	virtual Byte		read();
+	virtual void		tick();
+	virtual bool		next_read_delay(Cycles& delay);
+
+	void				set_line_delay(Cycles n) { line_delay = n; };
 
 public:
 	virtual void		setup();
@@ -0,0 +1,113 @@
+//
+//	trace.cpp
+//
+
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "trace.h"
+
+// The ring is rounded up to a power of two records
+Trace::Trace(size_t capacity, const char* cpu)
+	: cpu(cpu)
+{
+	size_t n = 1;
+	while (n < capacity) {
+		n <<= 1;
+	}
+	ring.resize(n);
+	mask = n - 1;
+}
+
+Trace::~Trace()
+{
+	if (fp) {
+		stopping.store(true, std::memory_order_release);
+		drainer.join();
+		fclose(fp);
+	}
+}
+
+bool Trace::write_header(FILE* out) const
+{
+	TraceHeader hdr = {};
+
+	strncpy(hdr.magic, "usimtrc", sizeof hdr.magic);
+	strncpy(hdr.cpu, cpu, sizeof hdr.cpu - 1);
+	hdr.version = 2;
+	hdr.record_size = sizeof(TraceRecord);
+
+	return fwrite(&hdr, sizeof hdr, 1, out) == 1;
+}
+
+// Start writing every record to the named file as it's made
+bool Trace::stream(const char* filename)
+{
+	if (fp) {
+		return false;
+	}
+
+	fp = fopen(filename, "wb");
+	if (!fp) {
+		return false;
+	}
+	if (!write_header(fp)) {
+		fclose(fp);
+		fp = nullptr;
+		return false;
+	}
+
+	drainer = std::thread(&Trace::drain, this);
+	return true;
+}
+
+// Runs on its own thread, writing out as much of the ring as is
+// ready at once, until told to stop and nothing more is left
+void Trace::drain()
+{
+	for (;;) {
+		bool last = stopping.load(std::memory_order_acquire);
+		uint64_t t = tail.load(std::memory_order_relaxed);
+		uint64_t h = head.load(std::memory_order_acquire);
+
+		if (h == t) {
+			if (last) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// at most up to the end of the ring at a time
+		size_t start = t & mask;
+		size_t n = std::min<uint64_t>(h - t, ring.size() - start);
+		(void)fwrite(&ring[start], sizeof(TraceRecord), n, fp);
+		tail.store(t + n, std::memory_order_release);
+	}
+	fflush(fp);
+}
+
+// Write out the instructions still held in the ring, oldest first,
+// which must only be done while the CPU isn't running
+bool Trace::dump(const char* filename) const
+{
+	if (fp) {
+		return false;
+	}
+
+	FILE* out = fopen(filename, "wb");
+	if (!out) {
+		return false;
+	}
+
+	uint64_t h = head.load(std::memory_order_acquire);
+	uint64_t t = (h > ring.size()) ? h - ring.size() : 0;
+	bool ok = write_header(out);
+
+	while (ok && t < h) {
+		size_t start = t & mask;
+		size_t n = std::min<uint64_t>(h - t, ring.size() - start);
+		ok = fwrite(&ring[start], sizeof(TraceRecord), n, out) == n;
+		t += n;
+	}
+
+	return (fclose(out) == 0) && ok;
+}
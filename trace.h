@@ -0,0 +1,88 @@
+//
+//	trace.h
+//
+
+#pragma once
+
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "typedefs.h"
+
+/*
+ * one executed instruction, with the registers as they were
+ * before it ran - everything needed to render the text trace
+ */
+struct TraceRecord {
+	Cycles			time;		// clock when it started
+	Word			pc;
+	Word			s, u, x, y;
+	Byte			a, b, e, f;	// e and f are 6309 only
+	Byte			dp, cc;
+	Byte			cycles;		// taken to execute
+	Byte			code[5];	// the instruction's bytes
+};
+
+/*
+ * the start of a trace file, followed by as many TraceRecords
+ * as it holds, all in host byte order
+ */
+struct TraceHeader {
+	char			magic[8];	// "usimtrc"
+	char			cpu[8];		// "6809" or "6309"
+	uint32_t		version;
+	uint32_t		record_size;
+};
+
+/*
+ * a lock-free ring of TraceRecords written by the CPU
+ *
+ * when streaming, a background thread drains the ring to a file
+ * and the CPU waits whenever it gets a whole ring ahead; otherwise
+ * the ring is a flight recorder holding the last `capacity`
+ * instructions, to be written out with dump() once stopped
+ */
+class Trace {
+
+protected:
+	std::vector<TraceRecord>	ring;
+	size_t				mask;
+	const char*			cpu;
+
+	std::atomic<uint64_t>	head{0};	// next record to be written
+	std::atomic<uint64_t>	tail{0};	// next to be drained
+	std::atomic<bool>		stopping{false};
+
+	FILE*				fp = nullptr;
+	std::thread			drainer;
+
+	bool				write_header(FILE*) const;
+	void				drain();
+
+// Used by the CPU, between which it fills in the record
+public:
+	TraceRecord&		next() {
+						uint64_t h = head.load(std::memory_order_relaxed);
+						if (fp) {
+							while (h - tail.load(std::memory_order_acquire) > mask) {
+								std::this_thread::yield();
+							}
+						}
+						return ring[h & mask];
+					}
+
+	void				commit() {
+						head.fetch_add(1, std::memory_order_release);
+					}
+
+public:
+	bool				stream(const char* filename);
+	bool				dump(const char* filename) const;
+
+// Public constructor and destructor
+public:
+						Trace(size_t capacity, const char* cpu);
+	virtual				~Trace();
+
+};
@@ -0,0 +1,71 @@
+//
+//	tracedump.cpp
+//
+//	Renders a binary trace file as the same text that tron()
+//	writes to stderr
+//
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "disasm.h"
+#include "trace.h"
+
+static void render(const TraceRecord& r, const Disassembler& disasm, FILE* out)
+{
+	char flags[] = "EFHINZVC";
+	for (uint8_t i = 0, mask = 0x80; mask; ++i, mask >>= 1) {
+		if ((r.cc & mask) == 0) {
+			flags[i] = '-';
+		}
+	}
+	fprintf(out, "PC:%04X CC:%s S:%04X U:%04X A:%02X B:%02X X:%04X Y:%04X DP:%02X\r\n",
+		r.pc, flags, r.s, r.u, r.a, r.b, r.x, r.y, r.dp);
+
+	Disassembly insn;
+	disasm.decode(r.code, sizeof r.code, r.pc, insn);
+	fprintf(out, "/ %04X: [%2d] %-8s%s\r\n", r.pc, r.cycles, insn.mnemonic, insn.operand);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage: usim-tracedump <tracefile>\n");
+		return EXIT_FAILURE;
+	}
+
+	FILE* in = fopen(argv[1], "rb");
+	if (!in) {
+		perror(argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	TraceHeader hdr;
+	if (fread(&hdr, sizeof hdr, 1, in) != 1 ||
+		strncmp(hdr.magic, "usimtrc", sizeof hdr.magic) != 0 ||
+		hdr.version != 2 || hdr.record_size != sizeof(TraceRecord))
+	{
+		fprintf(stderr, "%s: not a trace file from this version\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	Disassembler::instruction_set set;
+	if (strcmp(hdr.cpu, "6809") == 0) {
+		set = Disassembler::mc6809_set;
+	} else if (strcmp(hdr.cpu, "6309") == 0) {
+		set = Disassembler::hd6309_set;
+	} else {
+		fprintf(stderr, "%s: unknown CPU \"%.8s\"\n", argv[1], hdr.cpu);
+		return EXIT_FAILURE;
+	}
+
+	Disassembler disasm(set);
+	TraceRecord r;
+	while (fread(&r, sizeof r, 1, in) == 1) {
+		render(r, disasm, stdout);
+	}
+
+	fclose(in);
+	return EXIT_SUCCESS;
+}
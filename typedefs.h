@@ -22,3 +22,4 @@
 typedef uint8_t		Byte;
 typedef uint16_t	Word;
 typedef uint32_t	DWord;
+typedef uint64_t	Cycles;
@@ -8,6 +8,7 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <algorithm>
 #include "usim.h"
 
 //----------------------------------------------------------------------------
@@ -22,18 +23,103 @@ void USim::run()
 	}
 }
 
+// Run for at least the given number of cycles, returning the number
+// actually used, which may overrun by part of an instruction
+Cycles USim::run_for(Cycles n)
+{
+	Cycles start = clock.now;
+	run_limit = start + n;
+
+	halted = false;
+	while (!halted && clock.now < run_limit) {
+		tick();
+	}
+	run_limit = UINT64_MAX;
+	return clock.now - start;
+}
+
+// Run until the next instruction to execute is at `addr`
+Cycles USim::run_until(Word addr)
+{
+	Cycles start = clock.now;
+
+	halted = false;
+	while (!halted && pc != addr) {
+		tick();
+	}
+	return clock.now - start;
+}
+
+// Run until `done` returns true, checked before each instruction
+Cycles USim::run_until(const std::function<bool()>& done)
+{
+	Cycles start = clock.now;
+
+	halted = false;
+	while (!halted && !done()) {
+		tick();
+	}
+	return clock.now - start;
+}
+
+// The CPU calls this before each instruction, and advances the
+// clock by that instruction's cycles once it has completed
 void USim::tick()
 {
-	// assume one cycle happens every time
-	++cycles;
+	// only call into the devices when one of them is due
+	if (clock.now >= clock.next_event) {
+		tick_devices();
+	}
+}
 
-	// update all active devices
-	for (auto& d : dev_active) {
-		d.device->tick(cycles);
+// The guest can only repeat the same `period` cycles long sequence
+// until the next device event, so move the clock on by as many whole
+// periods as fit before then, first giving that device the chance to
+// block the host if it is the only one with anything pending.
+// Returns the number of periods skipped.
+uint64_t USim::skip_idle(Cycles period)
+{
+	Cycles until = std::min(clock.next_event, run_limit);
+	if (until == UINT64_MAX || until <= clock.now + period) {
+		return 0;
 	}
 
-	// reset the cycle counter
-	cycles = 0;
+	if (until == clock.next_event) {
+		ActiveDevice* due = nullptr;
+		unsigned pending = 0;
+		for (auto& d : dev_active) {
+			if (d.device->wakeup != UINT64_MAX) {
+				due = d.device.get();
+				++pending;
+			}
+		}
+		if (pending == 1) {
+			due->idle();
+		}
+	}
+
+	uint64_t n = (until - 1 - clock.now) / period;
+	clock.now += n * period;
+	return n;
+}
+
+void USim::tick_devices()
+{
+	// devices lower this again through wake_at()
+	clock.next_event = UINT64_MAX;
+
+	// device state may change without the CPU touching it
+	++side_effects;
+
+	for (auto& d : dev_active) {
+		ActiveDevice& dev = *d.device;
+		if (dev.wakeup <= clock.now) {
+			dev.tick(clock.now);
+		}
+		if (dev.wakeup < clock.next_event) {
+			clock.next_event = dev.wakeup;
+		}
+	}
 }
 
 void USim::reset()
@@ -55,11 +141,6 @@ void USim::invalid(const char *msg)
 	this->abort();
 }
 
-Byte USim::fetch()
-{
-	return read(pc++);
-}
-
 //----------------------------------------------------------------------------
 // Device handling
 //----------------------------------------------------------------------------
@@ -67,39 +148,237 @@ Byte USim::fetch()
 void USim::attach(const ActiveDevice::shared_ptr& dev)
 {
 	dev_active.push_back({ dev });
+	dev->set_clock(&clock);
 }
 
 void USim::attach(const MappedDevice::shared_ptr& dev, Word base, Word mask, rank<0>)
 {
 	dev_mapped.push_back({ dev, base, mask });
+	map_pages();
 }
 
 void USim::attach(const ActiveMappedDevice::shared_ptr& dev, Word base, Word mask, rank<1>)
 {
 	dev_active.push_back({ dev });
+	dev->set_clock(&clock);
 	dev_mapped.push_back({ dev, base, mask });
+	map_pages();
+}
+
+// rebuild the page table so that pages wholly owned by one
+// device can be dispatched without scanning dev_mapped
+void USim::map_pages()
+{
+	for (unsigned page = 0; page < 256; ++page) {
+		const MappedDeviceEntry* owner = nullptr;
+		bool shared = false;
+
+		for (unsigned i = 0; i < 256 && !shared; ++i) {
+			Word offset = (page << 8) | i;
+			const MappedDeviceEntry* found = nullptr;
+			for (auto& d : dev_mapped) {
+				if ((offset & d.mask) == d.base) {
+					found = &d;
+					break;
+				}
+			}
+			if (i == 0) {
+				owner = found;
+			} else if (found != owner) {
+				shared = true;
+			}
+		}
+
+		if (owner && !shared) {
+			MappedDevice* dev = owner->device.get();
+			Word offset = (page << 8) - owner->base;
+			pages[page] = {
+				dev, owner->base,
+				dev->read_ptr(offset, 256),
+				dev->write_ptr(offset, 256)
+			};
+		} else {
+			pages[page] = { nullptr, 0, nullptr, nullptr };
+		}
+	}
+
+	// find any memory in pages that can't be written directly,
+	// which snapshots must then save a byte at a time
+	scattered.clear();
+	for (unsigned page = 0; page < 256; ++page) {
+		if (pages[page].write) continue;
+		for (unsigned i = 0; i < 256; ++i) {
+			Word offset = (page << 8) | i;
+			for (auto& d : dev_mapped) {
+				if ((offset & d.mask) == d.base) {
+					Byte* p = d.device->write_ptr(offset - d.base, 1);
+					if (p) {
+						scattered.emplace_back(offset, p);
+					}
+					break;
+				}
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------
+// Snapshots
+//----------------------------------------------------------------------------
+
+// every attached device once, in attachment order
+std::vector<Stateful*> USim::stateful_devices()
+{
+	std::vector<Stateful*> list;
+
+	auto add = [&](Stateful* dev) {
+		for (auto d : list) {
+			if (d == dev) return;
+		}
+		list.push_back(dev);
+	};
+
+	for (auto& d : dev_mapped) {
+		add(d.device.get());
+	}
+	for (auto& d : dev_active) {
+		add(d.device.get());
+	}
+
+	return list;
+}
+
+void USim::save_state(StateBuffer& state)
+{
+	state.put(ir);
+	state.put(pc);
+	state.put(clock.now);
+	state.put(instructions);
+}
+
+void USim::restore_state(StateReader& state)
+{
+	state.get(ir);
+	state.get(pc);
+	state.get(clock.now);
+	state.get(instructions);
+	cycles = 0;
+}
+
+void USim::save(Snapshot& snap)
+{
+	snap.cpu = StateBuffer();
+	save_state(snap.cpu);
+
+	auto devices = stateful_devices();
+	snap.devices.assign(devices.size(), StateBuffer());
+	for (size_t i = 0; i < devices.size(); ++i) {
+		devices[i]->save(snap.devices[i]);
+	}
+
+	snap.wakeups.clear();
+	for (auto& d : dev_active) {
+		snap.wakeups.push_back(d.device->wakeup);
+	}
+
+	// only copy the pages written since they were last copied
+	for (unsigned page = 0; page < 256; ++page) {
+		const Byte* mem = pages[page].write;
+		if (!mem) {
+			snap.pages[page] = nullptr;
+			continue;
+		}
+		if (!page_copy[page] || page_copy_gen[page] != page_gen[page]) {
+			auto copy = std::make_shared<Snapshot::Page>();
+			std::copy(mem, mem + 256, copy->begin());
+			page_copy[page] = copy;
+			page_copy_gen[page] = page_gen[page];
+		}
+		snap.pages[page] = page_copy[page];
+	}
+
+	snap.scattered.clear();
+	for (auto& b : scattered) {
+		snap.scattered.push_back(*b.second);
+	}
+}
+
+void USim::restore(const Snapshot& snap)
+{
+	StateReader cpu(snap.cpu);
+	restore_state(cpu);
+
+	auto devices = stateful_devices();
+	for (size_t i = 0; i < devices.size() && i < snap.devices.size(); ++i) {
+		StateReader state(snap.devices[i]);
+		devices[i]->restore(state);
+	}
+
+	clock.next_event = UINT64_MAX;
+	for (size_t i = 0; i < dev_active.size() && i < snap.wakeups.size(); ++i) {
+		ActiveDevice& dev = *dev_active[i].device;
+		dev.wakeup = snap.wakeups[i];
+		clock.next_event = std::min(clock.next_event, dev.wakeup);
+	}
+
+	// only rewrite the pages that no longer hold the saved contents,
+	// bumping page_gen so that nothing cached from them is reused
+	for (unsigned page = 0; page < 256; ++page) {
+		Byte* mem = pages[page].write;
+		const auto& saved = snap.pages[page];
+		if (!mem || !saved) continue;
+		if (page_copy[page] == saved && page_copy_gen[page] == page_gen[page]) {
+			continue;
+		}
+		std::copy(saved->begin(), saved->end(), mem);
+		page_copy[page] = saved;
+		page_copy_gen[page] = ++page_gen[page];
+	}
+
+	for (size_t i = 0; i < scattered.size() && i < snap.scattered.size(); ++i) {
+		*scattered[i].second = snap.scattered[i];
+		++page_gen[scattered[i].first >> 8];
+	}
+
+	// forget anything learned about the code that was running
+	++side_effects;
 }
 
 //----------------------------------------------------------------------------
 // Mapped Device IO
 //----------------------------------------------------------------------------
 
-// Single byte read
-Byte USim::read(Word offset)
+// Single byte read from a device
+Byte USim::read_device(Word offset)
 {
-	++cycles;
+	const MappedPage& page = pages[offset >> 8];
+	if (page.device) {
+		if (!page.device->read_is_passive(offset - page.base)) {
+			++side_effects;
+		}
+		return page.device->read(offset - page.base);
+	}
+
 	for (auto& d : dev_mapped) {
 		if ((offset & d.mask) == d.base) {
+			if (!d.device->read_is_passive(offset - d.base)) {
+				++side_effects;
+			}
 			return d.device->read(offset - d.base);
 		}
 	}
 	return 0xff;
 }
 
-// Single byte write
-void USim::write(Word offset, Byte val)
+// Single byte write to a device
+void USim::write_device(Word offset, Byte val)
 {
-	++cycles;
+	const MappedPage& page = pages[offset >> 8];
+	if (page.device) {
+		page.device->write(offset - page.base, val);
+		return;
+	}
+
 	for (auto& d : dev_mapped) {
 		if ((offset & d.mask) == d.base) {
 			d.device->write(offset - d.base, val);
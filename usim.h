@@ -9,10 +9,42 @@
 #pragma once
 
 #include <cstdlib>
+#include <array>
 #include "device.h"
 #include "memory.h"
 #include "wiring.h"
 #include "bits.h"
+#include "profile.h"
+
+// only held by pointer here, so trace.h and its threads stay out
+// of every file that includes this one
+class Trace;
+struct TraceRecord;
+
+/*
+ * a saved copy of a whole machine: the CPU, every attached device
+ * and the contents of writable memory
+ *
+ * memory pages are shared and never modified once taken, so that a
+ * snapshot need only copy the pages written since the last one, and
+ * restoring only rewrites the pages that differ
+ *
+ * a snapshot can only be restored to the machine it was taken from,
+ * or to one built with exactly the same devices
+ */
+class Snapshot {
+
+	friend class USim;
+
+protected:
+	using Page = std::array<Byte, 256>;
+
+	StateBuffer			cpu;
+	std::vector<StateBuffer>	devices;
+	std::vector<Cycles>		wakeups;
+	std::shared_ptr<const Page>	pages[256];
+	std::vector<Byte>		scattered;	// see USim::scattered
+};
 
 /*
  * main system wide base class for CPU emulators
@@ -27,7 +59,14 @@ protected:
 
 		bool		m_trace = false;
 		bool		halted = true;
-		uint8_t		cycles = 0;
+		uint8_t		cycles = 0;	// in the current instruction
+		Clock		clock;		// total cycles since startup
+		uint64_t	instructions = 0;	// executed since startup
+		uint32_t	side_effects = 0;	// bumped by writes, active reads
+							// and device ticks
+		Cycles		run_limit = UINT64_MAX;	// end of the current run_for()
+
+		uint64_t	skip_idle(Cycles period);
 
 // Generic internal registers that we assume all CPUs have
 
@@ -37,16 +76,29 @@ protected:
 // Generic read/write/execute functions
 public:
 
-	virtual Byte		read(Word offset);
+		Byte		read(Word offset);
 	virtual Word		read_word(Word offset) = 0;
-	virtual void		write(Word offset, Byte val);
+		void		write(Word offset, Byte val);
 	virtual void		write_word(Word offset, Word val) = 0;
-	virtual Byte		fetch();
+		Byte		fetch();
+
+// Reads without side effects, for debugging, seeing only plain memory
+public:
+		void		peek(Word offset, Byte* buf, size_t len) const;
+
+protected:
+		Byte		read_device(Word offset);
+		void		write_device(Word offset, Byte val);
 
 // Device handling:
 protected:
 		ActiveDevList	dev_active;
 		MappedDevList	dev_mapped;
+		MappedPage	pages[256] = {};
+		uint32_t	page_gen[256] = {};	// bumped on every write
+
+		void		map_pages();
+		void		tick_devices();
 
 	virtual void		attach(const MappedDevice::shared_ptr& dev, Word base, Word mask, rank<0>);
 	virtual void		attach(const ActiveMappedDevice::shared_ptr& dev, Word base, Word mask, rank<1>);
@@ -59,22 +111,131 @@ public:
 					attach(dev, base, mask, rank<2>{});
 				};
 
+// Snapshot support
+protected:
+		std::shared_ptr<const Snapshot::Page>	page_copy[256];	// page contents
+		uint32_t	page_copy_gen[256] = {};	// as of this page_gen
+		std::vector<std::pair<Word, Byte*>>
+				scattered;	// writable bytes not in whole pages
+
+		std::vector<Stateful*>	stateful_devices();
+
+	virtual void		save_state(StateBuffer& state);
+	virtual void		restore_state(StateReader& state);
+
+public:
+		void		save(Snapshot& snap);
+		void		restore(const Snapshot& snap);
+
 // Functions to start and stop the virtual processor
 public:
 
 	std::function<void()>	abort = ::abort;
 	virtual void		invalid(const char*);
 	virtual void		run();
+	virtual Cycles		run_for(Cycles n);
+	virtual Cycles		run_until(Word addr);
+	virtual Cycles		run_until(const std::function<bool()>& done);
 	virtual void		tick();
 	virtual void		halt();
 	virtual void		reset();
 
+// Elapsed guest time, never reset, shared with the devices
+		Cycles		cycle_count() const { return clock.now; };
+		uint64_t	instruction_count() const { return instructions; };
+
 // Debugging
+		Word		get_pc() const { return pc; };
 		void		tron() { m_trace = true; };
 		void		troff() { m_trace = false; };
 
+// Binary tracing, into a ring shared with whoever drains or dumps it
+protected:
+		std::shared_ptr<Trace>	tracer;
+
+public:
+		void		trace_to(const std::shared_ptr<Trace>& t) { tracer = t; };
+
+// Profiling, counted only when built with -DPROFILE
+protected:
+		std::shared_ptr<Profile>	profiler;
+		std::shared_ptr<CallGraph>	call_graph;
+
+		// called once a call or return has set PC and S
+		void		profile_call(Word sp);
+		void		profile_return(Word sp);
+
+public:
+		void		profile_to(const std::shared_ptr<Profile>& p) { profiler = p; };
+		void		call_graph_to(const std::shared_ptr<CallGraph>& g) { call_graph = g; };
+
 };
 
+//----------------------------------------------------------------------------
+// Byte access, with plain memory pages read and written directly
+// and everything else dispatched to the owning device
+//----------------------------------------------------------------------------
+
+inline Byte USim::read(Word offset)
+{
+	++cycles;
+
+	const MappedPage& page = pages[offset >> 8];
+	if (page.read) {
+		return page.read[offset & 0xff];
+	}
+	return read_device(offset);
+}
+
+inline void USim::write(Word offset, Byte val)
+{
+	++cycles;
+	++page_gen[offset >> 8];
+	++side_effects;
+
+	const MappedPage& page = pages[offset >> 8];
+	if (page.write) {
+		page.write[offset & 0xff] = val;
+	} else {
+		write_device(offset, val);
+	}
+}
+
+inline Byte USim::fetch()
+{
+	return read(pc++);
+}
+
+inline void USim::peek(Word offset, Byte* buf, size_t len) const
+{
+	for (size_t i = 0; i < len; ++i, ++offset) {
+		const MappedPage& page = pages[offset >> 8];
+		buf[i] = page.read ? page.read[offset & 0xff] : 0xff;
+	}
+}
+
+inline void USim::profile_call(Word sp)
+{
+#ifdef PROFILE
+	if (call_graph) {
+		call_graph->call(pc, sp, clock.now + cycles);
+	}
+#else
+	(void)sp;
+#endif
+}
+
+inline void USim::profile_return(Word sp)
+{
+#ifdef PROFILE
+	if (call_graph) {
+		call_graph->ret(sp, clock.now + cycles);
+	}
+#else
+	(void)sp;
+#endif
+}
+
 class USimMotorola : virtual public USim {
 
 // Memory access functions taking target byte order into account
@@ -9,15 +9,12 @@
 #pragma once
 
 #include <functional>
+#include <vector>
 
 //---------------------------------------------------------------------
 //
-// helper functions for InputPin and Input Port
+// helper functions for InputPort
 //
-static inline constexpr bool default_true() {
-	return true;
-}
-
 static inline constexpr uint8_t default_high() {
 	return 0xff;
 }
@@ -111,13 +108,15 @@ public:
 // a developer-supplied function that typically will
 // poll the state of one or more Output* objects
 //
+// An unbound pin reads high without any function call.
+//
 class InputPin {
 
 protected:
 	using Function = std::function<bool()>;
 
 protected:
-	Function		f = default_true;
+	Function		f;
 
 public:
 	void			bind(const Function& _f) {
@@ -125,7 +124,34 @@ public:
 				}
 
 	bool			get() const {
-					return f();
+					return f ? f() : true;
+				}
+
+	operator		bool() const {
+					return get();
+				}
+};
+
+//---------------------------------------------------------------------
+//
+// InputLine:
+//
+// An active low input whose state is pushed to it by one
+// or more connected OutputLines, rather than polled.  Like
+// an open collector IRQ line it reads low while any of them
+// is pulling it low.
+//
+class InputLine {
+
+protected:
+	unsigned		low = 0;	// outputs pulling it low
+
+public:
+	void			pull_low() { ++low; }
+	void			release() { --low; }
+
+	bool			get() const {
+					return low == 0;
 				}
 
 	operator		bool() const {
@@ -133,6 +159,41 @@ public:
 				}
 };
 
+//---------------------------------------------------------------------
+//
+// OutputLine:
+//
+// The driving end of one or more InputLines.  The device
+// calls set() with the new pin level, and connected inputs
+// are only updated when that level actually changes.
+//
+class OutputLine {
+
+protected:
+	std::vector<InputLine*>	inputs;
+	bool			low = false;
+
+public:
+	void			connect(InputLine& in) {
+					inputs.push_back(&in);
+					if (low) in.pull_low();
+				}
+
+	void			set(bool level) {
+					if (low == !level) return;
+					low = !level;
+					for (auto in : inputs) {
+						if (low) {
+							in->pull_low();
+						} else {
+							in->release();
+						}
+					}
+				}
+
+				operator bool() const { return !low; }
+};
+
 //---------------------------------------------------------------------
 //
 // InputPort<N>